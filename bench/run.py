@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+"""Runs the benchmark corpus under ringci and as ringc-built binaries.
+
+Each program of bench/corpus takes one size parameter, written as @N@ in its source.
+For every program and mode the runner measures wall time, retired instructions (when
+`perf` is available) and peak RSS of each repetition, and writes them as JSON so runs of
+different commits can be compared:
+
+    bench/run.py --ringci build/bin/ringci --ringc build/bin/ringc --rtlib build/lib \\
+        --reps 5 --out base.json
+    bench/run.py --compare base.json new.json
+"""
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CORPUS = os.path.join(ROOT, "bench", "corpus")
+
+# Default size of each program, and what it stresses.
+PROGRAMS = {
+    "fib": (30, "recursion"),
+    "arith": (1000000, "int arithmetic and locals"),
+    "branch": (30000, "branching, tail calls"),
+    "tak": (28, "calls with three arguments"),
+    "fncall": (1000000, "calls through first-class functions"),
+}
+
+MODES = ["ringci", "ringc"]
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(
+            ["git", "-C", ROOT, "rev-parse", "--short", "HEAD"],
+            stderr=subprocess.DEVNULL).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def write_source(workdir, name, size):
+    with open(os.path.join(CORPUS, name + ".ring")) as f:
+        src = f.read().replace("@N@", str(size))
+    path = os.path.join(workdir, name + ".ring")
+    with open(path, "w") as f:
+        f.write(src)
+    return path
+
+
+def env_with_rtlib(rtlib):
+    env = dict(os.environ)
+    if rtlib:
+        for key in ("LIBRARY_PATH", "LD_LIBRARY_PATH"):
+            env[key] = rtlib + (os.pathsep + env[key] if env.get(key) else "")
+    return env
+
+
+def build_native(args, workdir, src):
+    """Builds `src` with ringc, which writes the binary under the module name in `workdir`."""
+    try:
+        res = subprocess.run([args.ringc, os.path.basename(src)], cwd=workdir,
+                             env=env_with_rtlib(args.rtlib),
+                             stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    except OSError as e:
+        return None, str(e)
+    binary = os.path.splitext(src)[0]
+    if res.returncode != 0 or not os.path.exists(binary):
+        return None, res.stdout.decode(errors="replace")
+    return binary, None
+
+
+def measure(cmd, env, use_perf):
+    """Runs `cmd` once and returns its output and measurements."""
+    perf_out = None
+    if use_perf:
+        fd, perf_out = tempfile.mkstemp(suffix=".perf")
+        os.close(fd)
+        cmd = ["perf", "stat", "-x,", "-e", "instructions:u", "-o", perf_out, "--"] + cmd
+
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, env=env, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    out = proc.stdout.read()
+    _, status, rusage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+
+    instructions = None
+    if perf_out:
+        with open(perf_out) as f:
+            for line in f:
+                fields = line.strip().split(",")
+                if len(fields) > 2 and fields[2].startswith("instructions") and fields[0].isdigit():
+                    instructions = int(fields[0])
+        os.unlink(perf_out)
+
+    return {
+        "exit": proc.returncode,
+        "output": out.decode(errors="replace").strip(),
+        "wall_s": wall,
+        "instructions": instructions,
+        "max_rss_kb": rusage.ru_maxrss,
+    }
+
+
+def run_benchmarks(args):
+    use_perf = not args.no_perf and shutil.which("perf") is not None
+    sizes = {name: size for name, (size, _) in PROGRAMS.items()}
+    for item in args.size:
+        name, _, size = item.partition("=")
+        sizes[name] = int(size)
+    names = [name for name in PROGRAMS if not args.filter or name in args.filter]
+    modes = [mode for mode in args.modes.split(",") if mode]
+
+    results = []
+    workdir = tempfile.mkdtemp(prefix="ring-bench-")
+    try:
+        for name in names:
+            src = write_source(workdir, name, sizes[name])
+            for mode in modes:
+                if mode == "ringci":
+                    cmd = [args.ringci] + args.ringci_flag + [src]
+                    env = env_with_rtlib(args.rtlib)
+                elif mode == "ringc":
+                    binary, err = build_native(args, workdir, src)
+                    if binary is None:
+                        print("%-8s %-7s build failed: %s" % (name, mode, err.strip()[:200]),
+                              file=sys.stderr)
+                        results.append({"program": name, "size": sizes[name], "mode": mode,
+                                        "status": "build-failed", "runs": []})
+                        continue
+                    cmd = [binary]
+                    env = env_with_rtlib(args.rtlib)
+                else:
+                    sys.exit("unknown mode: " + mode)
+
+                runs = [measure(cmd, env, use_perf) for _ in range(args.reps)]
+                status = "ok" if all(run["exit"] == 0 for run in runs) else "failed"
+                results.append({"program": name, "size": sizes[name], "mode": mode,
+                                "status": status, "runs": runs})
+                report_line(results[-1])
+        check_outputs(results)
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    doc = {
+        "revision": git_revision(),
+        "date": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "reps": args.reps,
+        "perf": use_perf,
+        "results": results,
+    }
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(doc, f, indent=1)
+    else:
+        json.dump(doc, sys.stdout, indent=1)
+        print()
+
+
+def summary(result):
+    runs = result["runs"]
+    if not runs:
+        return None
+    instrs = [run["instructions"] for run in runs if run["instructions"] is not None]
+    return {
+        "median_s": statistics.median(run["wall_s"] for run in runs),
+        "min_s": min(run["wall_s"] for run in runs),
+        "instructions": statistics.median(instrs) if instrs else None,
+        "max_rss_kb": max(run["max_rss_kb"] for run in runs),
+    }
+
+
+def report_line(result):
+    s = summary(result)
+    instrs = "%.3e" % s["instructions"] if s["instructions"] is not None else "-"
+    print("%-8s %-7s %-7s median %9.4f s  min %9.4f s  instr %10s  rss %8d KB"
+          % (result["program"], result["mode"], result["status"], s["median_s"], s["min_s"],
+             instrs, s["max_rss_kb"]), file=sys.stderr)
+
+
+# The modes of a program should print the same result.
+def check_outputs(results):
+    by_program = {}
+    for result in results:
+        if result["status"] == "ok":
+            # ringci logs the value of main after the program output.
+            output = result["runs"][0]["output"].splitlines()
+            by_program.setdefault(result["program"], set()).add(output[0] if output else "")
+    for name, outputs in by_program.items():
+        if len(outputs) > 1:
+            print("%-8s outputs differ between modes: %s" % (name, sorted(outputs)),
+                  file=sys.stderr)
+
+
+def compare(base_path, new_path):
+    with open(base_path) as f:
+        base = json.load(f)
+    with open(new_path) as f:
+        new = json.load(f)
+    base_results = {(r["program"], r["mode"]): r for r in base["results"]}
+
+    print("%-8s %-7s %12s %12s %8s %10s" % ("program", "mode", "base s", "new s", "ratio",
+                                           "instr"))
+    for result in new["results"]:
+        key = (result["program"], result["mode"])
+        if key not in base_results:
+            continue
+        b, n = summary(base_results[key]), summary(result)
+        if b is None or n is None:
+            print("%-8s %-7s %12s" % (key[0], key[1], "n/a"))
+            continue
+        instr = "-"
+        if b["instructions"] and n["instructions"]:
+            instr = "%.3f" % (n["instructions"] / b["instructions"])
+        print("%-8s %-7s %12.4f %12.4f %8.3f %10s"
+              % (key[0], key[1], b["median_s"], n["median_s"], n["median_s"] / b["median_s"],
+                 instr))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--ringci", default="ringci", help="path of the ringci driver")
+    parser.add_argument("--ringc", default="ringc", help="path of the ringc driver")
+    parser.add_argument("--rtlib", help="directory of libringrt")
+    parser.add_argument("--modes", default=",".join(MODES), help="comma separated modes")
+    parser.add_argument("--ringci-flag", action="append", default=[],
+                        help="extra flag for ringci, e.g. -jit=false")
+    parser.add_argument("--reps", type=int, default=5, help="repetitions per program and mode")
+    parser.add_argument("--size", action="append", default=[], metavar="NAME=N",
+                        help="size parameter of a program")
+    parser.add_argument("--filter", action="append", help="run only the named programs")
+    parser.add_argument("--no-perf", action="store_true", help="do not count instructions")
+    parser.add_argument("--out", help="JSON output file, stdout if not given")
+    parser.add_argument("--compare", nargs=2, metavar=("BASE", "NEW"),
+                        help="compare two JSON outputs")
+    args = parser.parse_args()
+
+    if args.compare:
+        compare(*args.compare)
+    else:
+        run_benchmarks(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,16 @@
+# Runs the benchmark corpus under ringci and as ringc-built binaries.
+# Extra arguments of the runner are passed by BENCH_ARGS, e.g.
+#   make bench BENCH_ARGS="--reps 10 --filter fib"
+find_program(python3 python3)
+
+add_custom_target(
+	bench
+	COMMAND ${python3} ${RingRoot}/bench/run.py
+		--ringci ${BuildRoot}/bin/ringci
+		--ringc ${BuildRoot}/bin/ringc
+		--rtlib ${BuildRoot}/lib
+		--out ${BuildRoot}/bench.json
+		$(BENCH_ARGS)
+	WORKING_DIRECTORY ${BuildRoot}
+	)
+add_dependencies(bench ring)
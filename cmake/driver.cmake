@@ -6,10 +6,12 @@ macro(buildDriver driverName)
 	set(outBin ${outDir}/${driverName})
 	set(src ${SrcRoot}/driver/${driverName}.cpp)
 
+	# The natives of ringrt are only looked up by dlsym, so the libraries are kept even where the
+	# linker would drop the ones no symbol is taken from.
 	add_custom_command(
 		OUTPUT ${outBin}
 		COMMAND ${CMAKE_COMMAND} -E make_directory ${outDir}
-		COMMAND ${CXX} ${CXXFLAGS} -o ${outBin} ${src} ${outLibs} ${LDFLAGS}
+		COMMAND ${CXX} ${CXXFLAGS} -o ${outBin} ${src} -Wl,--no-as-needed ${outLibs} ${LDFLAGS}
 			    && touch ${outBin}
 		DEPENDS ${src} ${outLibs}
 		)
@@ -63,12 +63,12 @@ buildLib(ringrt)
 prepareLib(ringc)
 buildLib(ringc)
 
-#prepareLib(ringi)
-#buildLib(ringi)
+prepareLib(ringi)
+buildLib(ringi)
 
 
 add_dependencies(libringc ringrt)
-#add_dependencies(libringi libringc)
+add_dependencies(libringi libringc)
 
 add_custom_target(liball ALL)
 add_dependencies(liball ${outLibTargets})
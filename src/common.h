@@ -14,6 +14,7 @@ DEF_ID_TYPE(ScopeId)
 DEF_ID_TYPE(NodeId)
 DEF_ID_TYPE(TypeId)
 DEF_ID_TYPE(SymbolId)
+DEF_ID_TYPE(ConstId)
 
 const std::string MainName = "main";
 
@@ -73,6 +73,9 @@ int main(int argc, char** argv) {
 		Link link(&session);
 		link.link(&module);
 
+		// Reports the phases and the tables.
+		session.stats()->report(stderr);
+
 	} else {
 		fprintf(stderr, "Usage: ringc [OPTIONS] INPUT\n");
 	}
@@ -6,7 +6,6 @@ using namespace ring::ringc;
 using namespace ring::ringc::ast;
 using namespace ring::ringi;
 
-#if 0
 int main(int argc, char** argv) {
 	Config config;
 	for (int i = 1; i < argc; ++i) {
@@ -30,9 +29,8 @@ int main(int argc, char** argv) {
 		// Creates virtual module and block for REPL.
 		AstFactory ast_factory(&session);
 		Module* module = ast_factory.createModule();
-		FunctionType* fn_type = static_cast<FunctionType*>(
-				session.type_table()->getType(ast_factory.getFuncTypeId(
-					make_pair(vector<TypeId>(), PRIM_TYPE_NIL))));
+		TypeId fn_type = ast_factory.getFuncTypeId(
+				make_pair(vector<TypeId>(), ast_factory.getPrimTypeId(PRIM_TYPE_NIL)));
 		ExprFn* fn = ast_factory.createExprFn(
 				fn_type, vector<Ident>(), ast_factory.createExprBlock());
 		Let* let_fn = ast_factory.createLet(
@@ -44,9 +42,9 @@ int main(int argc, char** argv) {
 				);
 		module->addDecl(let_fn);
 		interpret.initREPL(module, const_cast<ExprBlock*>(fn->body()));
-		// Enter into the virtual module and block.
-		interpret.enterBlock(module->node_id());
-		interpret.enterBlock(fn->body()->node_id());
+		// Enter into the virtual module and function.
+		interpret.enterFrame(module->node_id());
+		interpret.enterFrame(fn->node_id());
 
 		// Loop.
 		while (true) {
@@ -59,15 +57,12 @@ int main(int argc, char** argv) {
 			}
 		}
 
-		// Exit from the virtual block and module.
-		interpret.exitBlock(fn->body()->node_id());
-		interpret.exitBlock(module->node_id());
+		// Exit from the virtual function and module.
+		interpret.exitFrame(fn->node_id());
+		interpret.exitFrame(module->node_id());
 	}
 
+	// Reports the phases and the tables.
+	session.stats()->report(stderr);
 	return 0;
 }
-#else
-int main() {
-	return 0;
-}
-#endif
\ No newline at end of file
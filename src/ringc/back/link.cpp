@@ -31,6 +31,8 @@ bool Link::link(ModuleInfo* module) {
 
 
 bool Link::writeModuleObject(ModuleInfo* module) {
+	PhaseTimer timer(session(), "llvm.codegen");
+
 	// LLVM pass manager
 	llvm::PassManager pm;
 
@@ -60,6 +62,8 @@ bool Link::writeModuleObject(ModuleInfo* module) {
 
 
 bool Link::linkOutput(ModuleInfo* module) {
+	PhaseTimer timer(session(), "link");
+
 	string link_command(session()->config()->linker());
 	link_command += " ";
 	link_command += module->obj_path();
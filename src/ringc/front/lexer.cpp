@@ -3,24 +3,30 @@
 using namespace ring::ringc;
 
 
+// The reader is handed to the source map of the session, which keeps the source for diagnostics.
 Lexer::Lexer(FILE* fp, Session* session)
-		: _reader(fp)
-		, _session(session) {
+		: _reader(new Reader(fp))
+		, _session(session)
+		, _base(session->source_map()->add(_reader))
+		, _token_offset(0) {
 }
 
 
 Lexer::Lexer(const string& src, Session* session)
-		: _reader(src)
-		, _session(session) {
+		: _reader(new Reader(src))
+		, _session(session)
+		, _base(session->source_map()->add(_reader))
+		, _token_offset(0) {
 }
 
 
 // Returns next token.
 // TODO: scan string and character.
 Token Lexer::nextToken() {
-	char ch = _reader.consumeWhitespaceAndComments();
+	char ch = _reader->consumeWhitespaceAndComments();
+	_token_offset = _reader->offset();
 
-	if (_reader.isEof()) {
+	if (_reader->isEof()) {
 		return Token(Token::EoF);
 	}
 
@@ -36,91 +42,94 @@ Token Lexer::nextToken() {
 }
 
 
+void Lexer::tokenize(TokenBuffer* tokens) {
+	PhaseTimer timer(_session, "lex");
+	tokens->clear();
+	Token token(Token::INVALID);
+	do {
+		token = nextToken();
+		tokens->push(token.type(), token.str_id(), _base + _token_offset);
+	} while (!token.isEof());
+}
+
+
 // Scans identifier.
 Token Lexer::scanIdent() {
-	assert(LexUtil::isIdentStart(_reader.curr()));
+	assert(LexUtil::isIdentStart(_reader->curr()));
 
-	string token_str = "";
-	token_str += _reader.bump();
-	while (LexUtil::isIdentContinue(_reader.curr())) {
-		token_str += _reader.bump();
+	// Keywords are recognized before interning, so they never reach the string table.
+	llvm::StringRef token_str = _reader->bumpIdent();
+	Token reserved = TokenUtil::maybeReserved(token_str);
+	if (reserved.isValid()) {
+		return reserved;
 	}
-
-	return TokenUtil::reservedOrIdent(token_str, addToStrTable(token_str));
+	return Token(Token::IDENT, addToStrTable(token_str));
 }
 
 
 // Scans numeric literal.
-// TODO: scan haxadecimal numbers.
+// The literal is decoded later into the constant table, here only its text is kept.
 // TODO: scan rational numbers.
 Token Lexer::scanNumber() {
-	assert(LexUtil::isDecimalDigit(_reader.curr()));
+	assert(LexUtil::isDecimalDigit(_reader->curr()));
 
-	return Token(Token::LIT_NUMERIC, addToStrTable(scanDigits()));
+	size_t begin = _reader->offset();
+	if (_reader->bump_if('0') && (_reader->bump_if('x') || _reader->bump_if('X'))) {
+		_reader->bumpHexDigits();
+		return Token(Token::LIT_NUMERIC, addToStrTable(_reader->slice(begin, _reader->offset())));
+	}
+	_reader->bumpDigits();
+	return Token(Token::LIT_NUMERIC, addToStrTable(_reader->slice(begin, _reader->offset())));
 }
 
 
 // Scans string literal
 // TODO: handle escape characters
 Token Lexer::scanString() {
-	assert(LexUtil::isDoubleQuote(_reader.curr()));
+	assert(LexUtil::isDoubleQuote(_reader->curr()));
 
-	_reader.bump();
+	_reader->bump();
 
-	string token_str = "";
-	token_str += _reader.bump();
-	while (!LexUtil::isDoubleQuote(_reader.curr())) {
-		token_str += _reader.bump();
+	llvm::StringRef token_str;
+	if (!_reader->bumpUntil('"', &token_str)) {
+		_session->diagnostic()->report(REPORT_ERROR, "%s", "Unterminated string literal");
+		while (!_reader->isEof()) {
+			_reader->bump();
+		}
+		return Token(Token::INVALID);
 	}
 
-	assert(LexUtil::isDoubleQuote(_reader.curr()));
-
-	_reader.bump();
+	_reader->bump();
 
 	return Token(Token::LIT_STRING, addToStrTable(token_str));
 }
 
 
-// Scans digits.
-// TODO: scan haxadecimal numbers.
-string Lexer::scanDigits() {
-	string res = "";
-	while (!_reader.isEof()) {
-		if (LexUtil::isDecimalDigit(_reader.curr())) {
-			res += _reader.bump();
-		} else {
-			break;
-		}
-	}
-	return res;
-}
-
-
 Token Lexer::scanOperatorOrStructure() {
-	assert(!LexUtil::isIdentStart(_reader.curr())
-		&& !LexUtil::isDecimalDigit(_reader.curr()));
+	assert(!LexUtil::isIdentStart(_reader->curr())
+		&& !LexUtil::isDecimalDigit(_reader->curr()));
 
-	char ch = _reader.bump();
+	char ch = _reader->bump();
 
 	if (ch == '=') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::EQ);
 		} else {
 			return Token(Token::ASSIGN);
 		}
 	} else if (ch == '!') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::NE);
 		} else {
 			return Token(Token::NOT);
 		}
 	} else if (ch == '<') {
-		if (_reader.bump_if('-')) {
+		if (_reader->bump_if('-')) {
 			return Token(Token::LARROW);
-		} else if (_reader.bump_if('=')) {
+		} else if (_reader->bump_if('=')) {
 			return Token(Token::LE);
-		} else if (_reader.bump_if('<')) {
-			if (_reader.bump_if('=')) {
+		} else if (_reader->bump_if('<')) {
+			if (_reader->bump_if('=')) {
 				return Token(Token::ASSIGN_LSH);
 			} else {
 				return Token(Token::LSH);
@@ -129,10 +138,10 @@ Token Lexer::scanOperatorOrStructure() {
 			return Token(Token::LT);
 		}
 	} else if (ch == '>') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::GE);
-		} else if (_reader.bump_if('>')) {
-			if (_reader.bump_if('=')) {
+		} else if (_reader->bump_if('>')) {
+			if (_reader->bump_if('=')) {
 				return Token(Token::ASSIGN_RSH);
 			} else {
 				return Token(Token::RSH);
@@ -141,57 +150,57 @@ Token Lexer::scanOperatorOrStructure() {
 			return Token(Token::GT);
 		}
 	} else if (ch == '+') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::ASSIGN_ADD);
 		} else {
 			return Token(Token::ADD);
 		}
 	} else if (ch == '-') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::ASSIGN_SUB);
-		} else if (_reader.bump_if('>')) {
+		} else if (_reader->bump_if('>')) {
 			return Token(Token::RARROW);
 		} else {
 			return Token(Token::SUB);
 		}
 	} else if (ch == '*') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::ASSIGN_MUL);
-		} else if (_reader.bump_if('*')) {
+		} else if (_reader->bump_if('*')) {
 			return Token(Token::EXP);
 		} else {
 			return Token(Token::MUL);
 		}
 	} else if (ch == '/') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::ASSIGN_DIV);
 		} else {
 			return Token(Token::DIV);
 		}
 	} else if (ch == '%') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::ASSIGN_MOD);
 		} else {
 			return Token(Token::MOD);
 		}
 	} else if (ch == '&') {
-		if (_reader.bump_if('&')) {
+		if (_reader->bump_if('&')) {
 			return Token(Token::ANDAND);
-		} else if (_reader.bump_if('=')) {
+		} else if (_reader->bump_if('=')) {
 			return Token(Token::ASSIGN_BITWISE_AND);
 		} else {
 			return Token(Token::AND);
 		}
 	} else if (ch == '|') {
-		if (_reader.bump_if('|')) {
+		if (_reader->bump_if('|')) {
 			return Token(Token::OROR);
-		} else if (_reader.bump_if('=')) {
+		} else if (_reader->bump_if('=')) {
 			return Token(Token::ASSIGN_BITWISE_OR);
 		} else {
 			return Token(Token::OR);
 		}
 	} else if (ch == '^') {
-		if (_reader.bump_if('=')) {
+		if (_reader->bump_if('=')) {
 			return Token(Token::ASSIGN_BITWISE_XOR);
 		} else {
 			return Token(Token::HAT);
@@ -229,6 +238,6 @@ Token Lexer::scanOperatorOrStructure() {
 }
 
 
-StrId Lexer::addToStrTable(const string& str) {
+StrId Lexer::addToStrTable(llvm::StringRef str) {
 	return _session->str_table()->add(str);
 }
@@ -2,9 +2,11 @@
 #define RING_RINGC_FRONT_LEXER_H
 
 
+#include <stdint.h>
 #include <string>
 #include "../session/session.h"
 #include "../syntax/token.h"
+#include "../syntax/token_buffer.h"
 #include "reader.h"
 using namespace std;
 using namespace ring::ringc;
@@ -21,19 +23,22 @@ public:
 
 	Token nextToken();
 
+	// Lexes the whole source into `tokens`, which ends with EoF.
+	void tokenize(TokenBuffer* tokens);
+
 protected:
 	Token scanIdent();
 	Token scanNumber();
 	Token scanString();
 	Token scanOperatorOrStructure();
 
-	string scanDigits();
-
-	StrId addToStrTable(const string& str);
+	StrId addToStrTable(llvm::StringRef str);
 
 protected:
-	Reader _reader;
+	Reader* _reader; // Owned by the source map of the session.
 	Session* _session;
+	uint32_t _base; // Base offset of the source in the source map.
+	size_t _token_offset; // Offset of the last token returned by nextToken().
 };
 
 
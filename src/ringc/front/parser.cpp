@@ -7,30 +7,28 @@
 using namespace std;
 using namespace ring::ringc;
 
-#define EXPECTED(a, b) ERROR("Expected `%s`, buf found `%s`", a, b);
+#define EXPECTED(a, b) ERROR("%s: Expected `%s`, buf found `%s`",\
+		_session->source_map()->location(currOffset()).c_str(), a, b);
 
 Parser::Parser(FILE* fp, Session* session)
-		: _lexer(fp, session)
-		, _curr_token(Token::INVALID)
-		, _next_token(Token::INVALID)
-		, _session(session) {
-	eat(); // _next_token to be the first token.
-	eat(); // _curr_token to be the first token, _next_token to be the next.
+		: _session(session)
+		, _lexer(fp, session)
+		, _ix(0) {
+	_lexer.tokenize(&_tokens);
 }
 
 
 Parser::Parser(const string& src, Session* session)
-		: _lexer(src, session)
-		, _curr_token(Token::INVALID)
-		, _next_token(Token::INVALID)
-		, _session(session) {
-	eat(); // _next_token to be the first token.
-	eat(); // _curr_token to be the first token, _next_token to be the next.
+		: _session(session)
+		, _lexer(src, session)
+		, _ix(0) {
+	_lexer.tokenize(&_tokens);
 }
 
 
 Module* Parser::parseProgram() {
 	ScopeTracer tracer(_session, "parseProgram()");
+	PhaseTimer timer(_session, "parse");
 	return parseModule();
 }
 
@@ -51,7 +49,7 @@ Stmt* Parser::parseStatement() {
 Module* Parser::parseModule() {
 	ScopeTracer tracer(_session, "parseModule()");
 
-	Module* module = ast_fac()->createModule();
+	Module* module = at(currOffset(), ast_fac()->createModule());
 
 	// Parse uses.
 	while (!isEof() && isType(Token::KEYWORD_USE)) {
@@ -87,6 +85,7 @@ Use* Parser::parseUse() {
 Extern* Parser::parseExtern() {
 	ScopeTracer tracer(_session, "parseExtern()");
 
+	uint32_t offset = currOffset();
 	// eat "extern".
 	eatType(Token::KEYWORD_EXTERN);
 	// eat "name".
@@ -96,7 +95,7 @@ Extern* Parser::parseExtern() {
 	// parse type
 	TypeId type_id= parseType();
 
-	return ast_fac()->createExtern(name, type_id);
+	return at(offset, ast_fac()->createExtern(name, type_id));
 }
 
 
@@ -104,7 +103,7 @@ Extern* Parser::parseExtern() {
 Stmt* Parser::parseStmt(bool is_global) {
 	ScopeTracer tracer(_session, "parseStmt()");
 
-	if (curr().type() == Token::KEYWORD_LET) {
+	if (currType() == Token::KEYWORD_LET) {
 		return parseLet(is_global);
 	} else {
 		return parseExpr();
@@ -119,6 +118,7 @@ Stmt* Parser::parseStmt(bool is_global) {
 Let* Parser::parseLet(bool is_global) {
 	ScopeTracer tracer(_session, "parseLet()");
 
+	uint32_t offset = currOffset();
 	// "pub" ?
 	bool is_pub = false;
 	if (is_global) {
@@ -156,7 +156,7 @@ Let* Parser::parseLet(bool is_global) {
 	}
 
 	// Return let expression.
-	return ast_fac()->createLet(is_pub, is_mut, name, type_id, expr);
+	return at(offset, ast_fac()->createLet(is_pub, is_mut, name, type_id, expr));
 }
 
 
@@ -165,7 +165,7 @@ Expr* Parser::parseExpr() {
 
 	Expr* expr = NULL;
 
-	switch (curr().type()) {
+	switch (currType()) {
 		case Token::LBRACE: expr = parseExprBlock(); break;
 		case Token::KEYWORD_FN: expr = parseExprFn(); break;
 		case Token::KEYWORD_IF: expr = parseExprIf(); break;
@@ -173,7 +173,7 @@ Expr* Parser::parseExpr() {
 	}
 
 	if (expr == NULL) {
-		FATAL("parse expression returns NULL - current token: %d", curr().type());
+		FATAL("parse expression returns NULL - current token: %d", currType());
 	}
 
 	return expr;
@@ -185,7 +185,7 @@ Expr* Parser::parseExpr() {
 ExprBlock* Parser::parseExprBlock() {
 	ScopeTracer tracer(_session, "parseExprBlock()");
 
-	ExprBlock* block = ast_fac()->createExprBlock();
+	ExprBlock* block = at(currOffset(), ast_fac()->createExprBlock());
 
 	// Eat '{' token.
 	eatType(Token::LBRACE);
@@ -196,7 +196,7 @@ ExprBlock* Parser::parseExprBlock() {
 			continue;
 		}
 		if (isType(Token::RBRACE)) {
-			block->addStatement(ast_fac()->createExprEmpty());
+			block->addStatement(at(currOffset(), ast_fac()->createExprEmpty()));
 			break;
 		}
 		// statement
@@ -224,6 +224,7 @@ ExprBlock* Parser::parseExprBlock() {
 ExprFn* Parser::parseExprFn() {
 	ScopeTracer tracer(_session, "parseExprFn()");
 
+	uint32_t offset = currOffset();
 	// Parse function prototype.
 	auto proto = parseFunctionType(true);
 
@@ -231,7 +232,7 @@ ExprFn* Parser::parseExprFn() {
 	ExprBlock* body = parseExprBlock();
 
 	// Creates functions definition ast node and returns it.
-	return ast_fac()->createExprFn(proto.first, proto.second,	body);
+	return at(offset, ast_fac()->createExprFn(proto.first, proto.second,	body));
 }
 
 
@@ -241,6 +242,7 @@ ExprFn* Parser::parseExprFn() {
 ExprIf* Parser::parseExprIf() {
 	ScopeTracer tracer(_session, "parseExprIf()");
 
+	uint32_t offset = currOffset();
 	// eat "if" keyword.
 	eatType(Token::KEYWORD_IF);
 
@@ -262,7 +264,7 @@ ExprIf* Parser::parseExprIf() {
 		}
 	}
 
-	return ast_fac()->createExprIf(test, con, alt);
+	return at(offset, ast_fac()->createExprIf(test, con, alt));
 }
 
 
@@ -270,15 +272,17 @@ ExprIf* Parser::parseExprIf() {
 ExprIdent* Parser::parseExprIdent() {
 	ScopeTracer tracer(_session, "parseExprIdent()");
 
-	return ast_fac()->createExprIdent(eatIdent());
+	uint32_t offset = currOffset();
+	return at(offset, ast_fac()->createExprIdent(eatIdent()));
 }
 
 
 ExprLiteral* Parser::parseExprLiteral() {
 	ScopeTracer tracer(_session, "parseExprLiteral()");
 
+	uint32_t offset = currOffset();
 	Token lit = currAndEat();
-	return ast_fac()->createExprLiteral(convertLiteralType(lit.type()), lit.str_id());
+	return at(offset, ast_fac()->createExprLiteral(convertLiteralType(lit.type()), lit.str_id()));
 }
 
 
@@ -306,7 +310,7 @@ Expr* Parser::parseExprPrimary() {
 
 	} else if (isType(Token::IDENT)) {
 		return parseExprIdent();
-	} else if (TokenUtil::isLiteral(curr().type())) {
+	} else if (TokenUtil::isLiteral(currType())) {
 		return parseExprLiteral();
 	} else if (isType(Token::LPAREN)) {
 		return parseExprGroup();
@@ -365,12 +369,12 @@ Expr* Parser::parseExprMemberOrCall(Expr* primary) {
 	Expr* res = primary;
 	while (isType(Token::LBRACKET) || isType(Token::DOT) || isType(Token::LPAREN)) {
 		if (maybeEatType(Token::LBRACKET)) {
-			res = ast_fac()->createExprMember(res, Property(parseExpr()));
+			res = at(res->offset(), ast_fac()->createExprMember(res, Property(parseExpr())));
 			eatType(Token::RBRACKET);
 		} else if (maybeEatType(Token::DOT)) {
-			res = ast_fac()->createExprMember(res, Property(eatIdent().name_id()));
+			res = at(res->offset(), ast_fac()->createExprMember(res, Property(eatIdent().name_id())));
 		} else if (maybeEatType(Token::LPAREN)) {
-			res = ast_fac()->createExprCall(res, parseArguments());
+			res = at(res->offset(), ast_fac()->createExprCall(res, parseArguments()));
 			eatType(Token::RPAREN);
 		}
 	}
@@ -394,9 +398,10 @@ vector<Expr*> Parser::parseArguments() {
 Expr* Parser::parseExprUnary() {
 	ScopeTracer tracer(_session, "parseExprUnary()");
 
-	if (TokenUtil::isUnaryOp(curr().type())) {
+	if (TokenUtil::isUnaryOp(currType())) {
+		uint32_t offset = currOffset();
 		UnaryOp op = convertUnaryOp(currAndEat().type());
-		return ast_fac()->createExprUnary(op, parseExprUnary());
+		return at(offset, ast_fac()->createExprUnary(op, parseExprUnary()));
 	} else {
 		return parseExprLeftHandSide();
 	}
@@ -410,7 +415,7 @@ Expr* Parser::parseExprExponential() {
 
 	Expr* expr = parseExprUnary();
 	while (maybeEatType(Token::EXP)) {
-		expr = ast_fac()->createExprBinary(BO_EXP, expr, parseExprUnary());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(BO_EXP, expr, parseExprUnary()));
 	}
 	return expr;
 }
@@ -424,7 +429,7 @@ Expr* Parser::parseExprMultiplicative() {
 	Expr* expr = parseExprExponential();
 	while (isType(Token::MUL) || isType(Token::DIV) || isType(Token::MOD)) {
 		BinaryOp op = convertBinaryOp(currAndEat().type());
-		expr = ast_fac()->createExprBinary(op, expr, parseExprExponential());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(op, expr, parseExprExponential()));
 	}
 	return expr;
 }
@@ -438,7 +443,7 @@ Expr* Parser::parseExprAdditive() {
 	Expr* expr = parseExprMultiplicative();
 	while (isType(Token::ADD) || isType(Token::SUB)) {
 		BinaryOp op = convertBinaryOp(currAndEat().type());
-		expr = ast_fac()->createExprBinary(op, expr, parseExprMultiplicative());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(op, expr, parseExprMultiplicative()));
 	}
 	return expr;
 }
@@ -452,7 +457,7 @@ Expr* Parser::parseExprShift() {
 	Expr * expr = parseExprAdditive();
 	while (isType(Token::LSH) || isType(Token::RSH)) {
 		BinaryOp op = convertBinaryOp(currAndEat().type());
-		expr = ast_fac()->createExprBinary(op, expr, parseExprAdditive());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(op, expr, parseExprAdditive()));
 	}
 	return expr;
 }
@@ -466,7 +471,7 @@ Expr* Parser::parseExprRelational() {
 	Expr* expr = parseExprShift();
 	while (isType(Token::LT) || isType(Token::LE) || isType(Token::GE) || isType(Token::GT)) {
 		BinaryOp op = convertBinaryOp(currAndEat().type());
-		expr = ast_fac()->createExprBinary(op, expr, parseExprShift());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(op, expr, parseExprShift()));
 	}
 	return expr;
 }
@@ -479,7 +484,7 @@ Expr* Parser::parseExprEquality() {
 	Expr* expr = parseExprRelational();
 	if (isType(Token::EQ) || isType(Token::NE)) {
 		BinaryOp op = convertBinaryOp(currAndEat().type());
-		expr = ast_fac()->createExprBinary(op, expr, parseExprRelational());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(op, expr, parseExprRelational()));
 	}
 	return expr;
 }
@@ -492,7 +497,7 @@ Expr* Parser::parseExprBitwiseAnd() {
 
 	Expr* expr = parseExprEquality();
 	while (maybeEatType(Token::AND)) {
-		expr = ast_fac()->createExprBinary(BO_BITWISE_AND, expr, parseExprEquality());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(BO_BITWISE_AND, expr, parseExprEquality()));
 	}
 	return expr;
 }
@@ -505,7 +510,7 @@ Expr* Parser::parseExprBitwiseXor() {
 
 	Expr* expr = parseExprBitwiseAnd();
 	while (maybeEatType(Token::HAT)) {
-		expr = ast_fac()->createExprBinary(BO_BITWISE_XOR, expr, parseExprBitwiseAnd());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(BO_BITWISE_XOR, expr, parseExprBitwiseAnd()));
 	}
 	return expr;
 }
@@ -518,7 +523,7 @@ Expr* Parser::parseExprBitwiseOr() {
 
 	Expr* expr = parseExprBitwiseXor();
 	while (maybeEatType(Token::OR)) {
-		expr = ast_fac()->createExprBinary(BO_BITWISE_OR, expr, parseExprBitwiseXor());
+		expr = at(expr->offset(), ast_fac()->createExprBinary(BO_BITWISE_OR, expr, parseExprBitwiseXor()));
 	}
 	return expr;
 }
@@ -531,7 +536,7 @@ Expr* Parser::parseExprLogicalAnd() {
 
 	Expr* expr = parseExprBitwiseOr();
 	while (maybeEatType(Token::ANDAND)) {
-		expr = ast_fac()->createExprLogical(LO_AND, expr, parseExprBitwiseOr());
+		expr = at(expr->offset(), ast_fac()->createExprLogical(LO_AND, expr, parseExprBitwiseOr()));
 	}
 	return expr;
 }
@@ -544,7 +549,7 @@ Expr* Parser::parseExprLogicalOr() {
 
 	Expr* expr = parseExprLogicalAnd();
 	while (maybeEatType(Token::OROR)) {
-		expr = ast_fac()->createExprLogical(LO_OR, expr, parseExprLogicalAnd());
+		expr = at(expr->offset(), ast_fac()->createExprLogical(LO_OR, expr, parseExprLogicalAnd()));
 	}
 	return expr;
 }
@@ -560,7 +565,7 @@ Expr* Parser::parseExprConditional() {
 		Expr* con = parseExprAssignment();
 		eatType(Token::COLON);
 		Expr* alt = parseExprAssignment();
-		return ast_fac()->createExprConditional(expr, con, alt);
+		return at(expr->offset(), ast_fac()->createExprConditional(expr, con, alt));
 	}
 	return expr;
 }
@@ -572,9 +577,9 @@ Expr* Parser::parseExprAssignment() {
 	ScopeTracer tracer(_session, "parseExprAssignment()");
 
 	Expr* expr = parseExprConditional();
-	if (TokenUtil::isAssigmentOp(curr().type())) {
+	if (TokenUtil::isAssigmentOp(currType())) {
 		AssignmentOp op = convertAssignmentOp(currAndEat().type());
-		return ast_fac()->createExprAssignment(op, expr, parseExpr());
+		return at(expr->offset(), ast_fac()->createExprAssignment(op, expr, parseExpr()));
 	}
 	return expr;
 }
@@ -659,9 +664,9 @@ bool Parser::needSemicolon(Stmt* stmt) {
 }
 
 
-StrId Parser::strId(const string& str) {
+StrId Parser::strId(llvm::StringRef str) {
 	if (!_session->str_table()->contains(str)) {
-		FATAL("No such string in the string table: %s", str.c_str());
+		FATAL("No such string in the string table: %s", str.str().c_str());
 	}
 	return _session->str_table()->id(str);
 }
@@ -672,13 +677,28 @@ bool Parser::isEof() const {
 }
 
 
+uint32_t Parser::currOffset() const {
+	return _tokens.offset(_ix);
+}
+
+
 Token Parser::curr() const {
-	return _curr_token;
+	return _tokens.token(_ix);
+}
+
+
+Token::TokenType Parser::currType() const {
+	return _tokens.type(_ix);
 }
 
 
 Token Parser::next() const {
-	return _next_token;
+	return _tokens.token(_ix + 1);
+}
+
+
+Token Parser::peek(size_t n) const {
+	return _tokens.token(_ix + n);
 }
 
 
@@ -688,18 +708,20 @@ bool Parser::isToken(const Token& token) const {
 
 
 bool Parser::isType(Token::TokenType type) const {
-	return curr().type() == type;
+	return currType() == type;
 }
 
 
+// EoF is never eaten, so the index stays in the buffer.
 void Parser::eat() {
-	_curr_token = _next_token;
-	_next_token = _lexer.nextToken();
+	if (_ix + 1 < _tokens.length()) {
+		++_ix;
+	}
 }
 
 
 Token Parser::currAndEat() {
-	Token res = _curr_token;
+	Token res = curr();
 	eat();
 	return res;
 }
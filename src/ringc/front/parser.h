@@ -32,6 +32,9 @@ public:
 	// Parse an statement under the assumption that the given source is an statement.
 	Stmt* parseStatement();
 
+	// Returns the tokens of the source, which are lexed once when the parser is created.
+	const TokenBuffer& tokens() const { return _tokens; }
+
 protected:
 	Module* parseModule();
 	Use* parseUse();
@@ -71,11 +74,16 @@ protected:
 
 	bool needSemicolon(Stmt* stmt);
 
-	StrId strId(const string& str);
+	StrId strId(llvm::StringRef str);
 
 	bool isEof() const;
+	// Returns the source offset of the current token.
+	uint32_t currOffset() const;
 	Token curr() const;
+	Token::TokenType currType() const;
 	Token next() const;
+	// Returns the token `n` tokens after the current one.
+	Token peek(size_t n) const;
 	bool isToken(const Token& token) const;
 	bool isType(Token::TokenType type) const;
 
@@ -91,11 +99,18 @@ protected:
 protected:
 	Lexer _lexer;
 
-	Token _curr_token;
-	Token _next_token;
+	TokenBuffer _tokens;
+	size_t _ix; // Index of the current token.
 
 	AstFactory* ast_fac();
 	AstStringify* ast_str();
+
+	// Sets the source offset of a node which has just been created, and returns it.
+	template <typename T>
+	T* at(uint32_t offset, T* node) {
+		node->offset(offset);
+		return node;
+	}
 };
 
 
@@ -1,104 +1,90 @@
 #include "reader.h"
+#include "scan.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 using namespace ring::ringc;
 
 
-Position::Position()
-		: _ch(0), _ix(-1), _row(0), _col(0) {
-}
-
-
-Position::Position(char ch, int ix, int row, int col)
-		: _ch(ch), _ix(ix), _row(row), _col(col) {
-}
-
-
-bool Position::isValid() const {
-	return _ix >= 0;
-}
-
-
-void Position::invalidate() {
-	_ix = -1;
-}
-
-
-int Position::ix() const {
-	return _ix;
-}
-
-
-char Position::ch() const {
-	if (isValid()) return _ch;
-	else NIL;
-}
-
-
-void Position::moveNextIdx() {
-	_ix += 1;
-}
+#define READ_CHUNK_SIZE (64 * 1024)
 
 
-void Position::moveNextCol() {
-	_col += 1;
-}
-
-
-void Position::moveNextRow() {
-	_col = 0;
-	_row += 1;
-}
-
-void Position::setChar(char ch) {
-	_ch = ch;
-}
-
-
-Reader::Reader(FILE* fp) {
-	char buffer[1024];
-	do {
-		int len = fread(buffer, 1, 1023, fp);
-		buffer[len] = 0;
-		_src += buffer;
-	} while (!feof(fp));
-	Initialize();
+Reader::Reader(FILE* fp)
+		: _src(NULL)
+		, _len(0)
+		, _ix(0)
+		, _map(NULL)
+		, _map_len(0) {
+	if (!mapFile(fp)) {
+		readStream(fp);
+	}
 }
 
 
 Reader::Reader(const string& src)
-		: _src(src) {
-	Initialize();
+		: _src(NULL)
+		, _len(0)
+		, _ix(0)
+		, _buffer(src)
+		, _map(NULL)
+		, _map_len(0) {
+	_src = _buffer.data();
+	_len = _buffer.size();
 }
 
 
-void Reader::Initialize() {
-	_len = _src.size();
-	if (_len > 0) {
-		_pos = Position(_src[0], 0, 0, 0);
-		_pos_n1 = nextPosition(_pos);
-		_pos_n2 = nextPosition(_pos_n1);
+Reader::~Reader() {
+	if (_map != NULL) {
+		munmap(_map, _map_len);
 	}
 }
 
 
-char Reader::curr() const {
-	return _pos.ch();
+// Maps a regular file from the current position of `fp` to its end.
+// Returns false if the file can not be mapped, then it should be read as a stream.
+bool Reader::mapFile(FILE* fp) {
+	struct stat st;
+	int fd = fileno(fp);
+	if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		return false;
+	}
+	long offset = ftell(fp);
+	if (offset < 0 || offset > st.st_size) {
+		return false;
+	}
+	void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	_map = map;
+	_map_len = st.st_size;
+	_src = reinterpret_cast<const char*>(map) + offset;
+	_len = st.st_size - offset;
+	return true;
 }
 
 
-bool Reader::isEof() const {
-	return !_pos.isValid();
+void Reader::readStream(FILE* fp) {
+	char buffer[READ_CHUNK_SIZE];
+	size_t len = 0;
+	while ((len = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+		_buffer.append(buffer, len);
+	}
+	_src = _buffer.data();
+	_len = _buffer.size();
 }
 
 
 // Consumes a char and returns that char.
 char Reader::bump() {
-	char res = _pos.ch();
-	if (_pos.isValid()) {
-		_pos = _pos_n1;
-		_pos_n1 = _pos_n2;
-		_pos_n2 = nextPosition(_pos_n2);
+	if (_ix < _len) {
+		return _src[_ix++];
 	}
-	return res;
+	return NIL;
 }
 
 
@@ -113,39 +99,48 @@ bool Reader::bump_if(char ch) {
 	}
 }
 
+
 // Consumes whitespaces or comments, and then returns the next char.
 char Reader::consumeWhitespaceAndComments() {
-	while (LexUtil::isWhitespace(curr())) {
-		bump();
-	}
+	_ix += ScanUtil::whitespaceRun(_src + _ix, _len - _ix);
 	return curr();
 }
 
 
-// Returns next position of given position.
-// If given position is invalid then returns invalid position.
-// If next position reaches eof then returns invalid position.
-// Else returns valid next position.
-Position Reader::nextPosition(const Position& pos) const {
-	Position newPos = pos;
-	if (newPos.isValid()) {
-		// Given position is valid, move to next position.
-		newPos.moveNextIdx();
-		if (newPos.ix() < _len) {
-			// Next position does not reach eof.
-			// Updates row and col.
-			newPos.setChar(_src[newPos.ix()]);
-			if (LexUtil::isNewLine(newPos.ch())) {
-				newPos.moveNextCol();
-			} else {
-				newPos.moveNextRow();
-			}
-		} else {
-			// Next position reaches eof, make it invalid.
-			newPos.invalidate();
-		}
+llvm::StringRef Reader::bumpIdent() {
+	return bumpRun(ScanUtil::identRun(_src + _ix, _len - _ix));
+}
+
+
+llvm::StringRef Reader::bumpDigits() {
+	return bumpRun(ScanUtil::digitRun(_src + _ix, _len - _ix));
+}
+
+
+llvm::StringRef Reader::bumpHexDigits() {
+	return bumpRun(ScanUtil::hexDigitRun(_src + _ix, _len - _ix));
+}
+
+
+bool Reader::bumpUntil(char ch, llvm::StringRef* res) {
+	const void* found = memchr(_src + _ix, ch, _len - _ix);
+	if (found == NULL) {
+		return false;
 	}
-	return newPos;
+	*res = bumpRun(reinterpret_cast<const char*>(found) - (_src + _ix));
+	return true;
+}
+
+
+llvm::StringRef Reader::slice(size_t begin, size_t end) const {
+	return llvm::StringRef(_src + begin, end - begin);
+}
+
+
+llvm::StringRef Reader::bumpRun(size_t len) {
+	llvm::StringRef res(_src + _ix, len);
+	_ix += len;
+	return res;
 }
 
 
@@ -189,6 +184,11 @@ bool LexUtil::isDecimalDigit(char ch) {
 }
 
 
+bool LexUtil::isHexDigit(char ch) {
+	return isDecimalDigit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+
 bool LexUtil::isAlphaNum(char ch) {
 	return isAlpha(ch) || isDecimalDigit(ch);
 }
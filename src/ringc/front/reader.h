@@ -2,7 +2,9 @@
 #define RING_RINGC_FRONT_READER_H
 
 
+#include <cstdio>
 #include <string>
+#include "llvm/ADT/StringRef.h"
 using namespace std;
 
 
@@ -12,54 +14,59 @@ namespace ringc {
 
 const char NIL = 0xff;
 
-struct Position {
-public:
-	Position();
-	Position(char ch, int ix, int row, int col);
-
-	bool isValid() const;
-	void invalidate();
-
-	int ix() const;
-	char ch() const;
-
-	void moveNextIdx();
-	void moveNextCol();
-	void moveNextRow();
-	void setChar(char ch);
-
-protected:
-	char _ch;
-	int _ix;
-	int _row;
-	int _col;
-};
-
 
+// Reader walks the characters of a source.
+// A regular file is mapped read-only and read in place. Other files, such as pipes and stdin, are
+// read into a buffer of the reader.
+// The position is a plain offset in the source, so runs of characters are consumed at once and
+// handed out as slices of the source.
 class Reader {
 public:
 	Reader(FILE* fp);
 	Reader(const string& src);
+	~Reader();
+
+	// The source may be mapped, so a reader is not copied.
+	Reader(const Reader&) = delete;
+	Reader& operator =(const Reader&) = delete;
 
-	char curr() const;
+	char curr() const { return _ix < _len ? _src[_ix] : NIL; }
 
-	bool isEof() const;
+	bool isEof() const { return _ix >= _len; }
 
 	char bump();
 	bool bump_if(char ch);
 	char consumeWhitespaceAndComments();
 
+	// Consumes a run of identifier characters, decimal or hex digits, and returns it.
+	llvm::StringRef bumpIdent();
+	llvm::StringRef bumpDigits();
+	llvm::StringRef bumpHexDigits();
+
+	// Consumes the chars before the next `ch`, and returns them.
+	// Returns false and consumes nothing if there is no `ch` until the end.
+	bool bumpUntil(char ch, llvm::StringRef* res);
+
+	size_t offset() const { return _ix; }
+
+	// Returns the length of the source.
+	size_t length() const { return _len; }
+
+	// Returns the source between two offsets.
+	llvm::StringRef slice(size_t begin, size_t end) const;
+
 protected:
-	Position nextPosition(const Position& pos) const;
-	bool readChunk();
-	void Initialize();
+	bool mapFile(FILE* fp);
+	void readStream(FILE* fp);
+	llvm::StringRef bumpRun(size_t len);
 
 protected:
-	string _src;
+	const char* _src;
 	size_t _len;
-	Position _pos;
-	Position _pos_n1;
-	Position _pos_n2;
+	size_t _ix;
+	string _buffer; // Characters of a source which is not mapped.
+	void* _map;
+	size_t _map_len;
 };
 
 
@@ -73,6 +80,7 @@ public:
 	static bool isLowerAlpha(char ch);
 	static bool isUpperAlpha(char ch);
 	static bool isDecimalDigit(char ch);
+	static bool isHexDigit(char ch);
 	static bool isAlphaNum(char ch);
 	static bool isDoubleQuote(char ch);
 };
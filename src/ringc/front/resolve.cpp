@@ -1,7 +1,9 @@
 #include "resolve.h"
 #include "resolve_ast.h"
 #include "resolve_symbol.h"
-#include "resolve_type.h"
+#include "resolve_type_flat.h"
+#include "resolve_fused.h"
+#include "resolve_verify.h"
 using namespace ring::ringc;
 
 
@@ -11,25 +13,62 @@ Resolver::Resolver(Session* session)
 
 
 void Resolver::resolve(AstNode* node) {
-	resolveAst(node);
-	resolveSymbol(node);
-	resolveType(node);
+	PhaseTimer timer(session(), "resolve");
+	if (session()->config()->fused_resolve()) {
+		PhaseTimer fused_timer(session(), "resolve.fused");
+		FusedResolver resolver(this, true);
+		resolver.resolve(node);
+	} else {
+		resolveAst(node);
+		resolveSymbol(node);
+		resolveType(node);
+	}
+	if (session()->config()->verify_resolve() && node->node_type() == AST_MODULE) {
+		ResolveVerifier verifier(session());
+		verifier.verify(static_cast<Module*>(node));
+	}
+}
+
+
+// Types are not resolved here, since the REPL evaluates the tree as it is.
+void Resolver::resolveStmt(Stmt* stmt, AstNode* parent) {
+	if (session()->config()->fused_resolve()) {
+		FusedResolver resolver(this, false);
+		resolver.resolve(stmt, parent);
+	} else {
+		AstResolver resolver;
+		resolver.resolve(stmt, parent);
+		resolveSymbol(stmt);
+	}
 }
 
 
 void Resolver::resolveAst(AstNode* node) {
+	PhaseTimer timer(session(), "resolve.ast");
 	AstResolver resolver;
 	resolver.resolve(node);
 }
 
 
 void Resolver::resolveSymbol(AstNode* node) {
+	PhaseTimer timer(session(), "resolve.symbol");
 	SymbolResolver resolver(this);
 	resolver.resolve(node);
 }
 
 
+// Types are resolved on the flat AST, which is built once the symbols are known.
 void Resolver::resolveType(AstNode* node) {
-	TypeResolver resolver(this);
-	resolver.resolve(node);
-}
\ No newline at end of file
+	flatten(node);
+	PhaseTimer timer(session(), "resolve.type");
+	FlatTypeResolver resolver(this);
+	resolver.resolve(session()->flat_ast());
+}
+
+
+void Resolver::flatten(AstNode* node) {
+	PhaseTimer timer(session(), "resolve.flat");
+	*session()->flat_ast() = FlatAst();
+	FlatAstBuilder builder(session()->flat_ast());
+	builder.build(node);
+}
@@ -27,8 +27,13 @@ class Resolver {
 public:
 	Resolver(Session* session);
 
+	// Resolves the AST rooted at `node`, in one fused traversal unless -fused-resolve=false.
+	// With -verify-resolve, a module is checked against the other path; see ResolveVerifier.
 	void resolve(AstNode* node);
 
+	// Resolves parents and symbols of a statement added to `parent`, as the REPL does.
+	void resolveStmt(Stmt* stmt, AstNode* parent);
+
 	// Resolve ast.
 	// - Resolve parent of nodes: All node of the AST become refer to their parent.
 	void resolveAst(AstNode* node);
@@ -38,7 +43,12 @@ public:
 	// When meet new name definition, create new entry on symbol table in scope chain.
 	void resolveSymbol(AstNode* node);
 
+	// Resolve types.
+	// Encodes the AST into the flat AST of the session, and finds the types of nodes on it.
 	void resolveType(AstNode* node);
+
+	// Encodes the resolved AST into the flat AST of the session.
+	void flatten(AstNode* node);
 };
 
 
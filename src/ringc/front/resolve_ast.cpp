@@ -6,8 +6,14 @@ AstResolver::AstResolver() {
 }
 
 
-void AstResolver::resolve(AstNode* node) {
+void AstResolver::resolve(AstNode* node, AstNode* parent) {
+	if (parent != NULL) {
+		_st.push(parent);
+	}
 	visit(node);
+	if (parent != NULL) {
+		_st.pop();
+	}
 }
 
 void AstResolver::onVisitPreNode(AstNode* node) {
@@ -24,3 +30,44 @@ void AstResolver::onVisitPostNode(AstNode* node) {
 	_st.pop();
 }
 
+
+// A call is in tail position when it is the last expression of a function body, possibly through
+// blocks and branches.
+void AstResolver::onVisitPreExprFn(ExprFn* fn) {
+	markTailCalls(fn->body());
+}
+
+
+// Marks the calls whose result becomes the value of `expr`.
+void AstResolver::markTailCalls(Expr* expr) {
+	if (expr == NULL) {
+		return;
+	}
+	switch (expr->node_type()) {
+		case AST_EXPR_BLOCK: {
+			ExprBlock* block = static_cast<ExprBlock*>(expr);
+			if (!block->stmts().empty() && block->stmts().back()->isExpr()) {
+				markTailCalls(static_cast<Expr*>(block->stmts().back()));
+			}
+			break;
+		}
+		case AST_EXPR_IF: {
+			ExprIf* if_ = static_cast<ExprIf*>(expr);
+			markTailCalls(if_->con());
+			markTailCalls(if_->alt());
+			break;
+		}
+		case AST_EXPR_CONDITIONAL: {
+			ExprConditional* cond = static_cast<ExprConditional*>(expr);
+			markTailCalls(cond->con());
+			markTailCalls(cond->alt());
+			break;
+		}
+		case AST_EXPR_CALL:
+			static_cast<ExprCall*>(expr)->tail(true);
+			break;
+		default:
+			break;
+	}
+}
+
@@ -19,17 +19,27 @@ namespace ring {
 namespace ringc {
 
 
-class AstResolver : public AstVisitor {
+// AST resolver links every node to its parent and marks the calls in tail position.
+class AstResolver : public AstVisitor<AstResolver> {
+	friend class AstVisitor<AstResolver>;
+	friend class FusedResolver;
+
 public:
 	AstResolver();
 
 	// Takes an ast node and start resolving.
-	void resolve(AstNode* node);
+	// The node is linked to `parent`, which is given when it is added to an existing tree.
+	void resolve(AstNode* node, AstNode* parent = NULL);
 
 protected:
 	void onVisitPreNode(AstNode* node);
 	void onVisitPostNode(AstNode* node);
 
+	ADD_VISITOR_PRE(ExprFn);
+
+	// Marks the calls whose result becomes the value of `expr`.
+	void markTailCalls(Expr* expr);
+
 protected:
 	stack<const AstNode*> _st;
 };
@@ -0,0 +1,22 @@
+#include "resolve_fused.h"
+using namespace ring::ringc;
+
+
+FusedResolver::FusedResolver(Resolver* resolver, bool resolve_type)
+		: _symbol(resolver)
+		, _type(resolver)
+		, _resolve_type(resolve_type) {
+}
+
+
+void FusedResolver::resolve(AstNode* node, AstNode* parent) {
+	if (parent != NULL) {
+		_ast._st.push(parent);
+	}
+	_symbol.enterScopes(parent);
+	visit(node);
+	_symbol.leaveScopes();
+	if (parent != NULL) {
+		_ast._st.pop();
+	}
+}
@@ -0,0 +1,90 @@
+#ifndef RING_RINGC_FRONT_RESOLVE_FUSED_H
+#define RING_RINGC_FRONT_RESOLVE_FUSED_H
+
+
+namespace ring {
+namespace ringc {
+	class FusedResolver;
+}}
+
+
+#include "../../common.h"
+#include "../syntax/ast_visitor.h"
+#include "../syntax/ast.h"
+#include "resolve.h"
+#include "resolve_ast.h"
+#include "resolve_symbol.h"
+#include "resolve_type.h"
+using namespace ring::ringc::ast;
+
+
+// Calls the handlers of the passes in the order the separate traversals would.
+#define FUSED_HANDLERS(type)\
+	void onVisitPre##type(type* node) {\
+		_ast.onVisitPre##type(node);\
+		_symbol.onVisitPre##type(node);\
+		if (_resolve_type) { _type.onVisitPre##type(node); }\
+	}\
+	void onVisitPost##type(type* node) {\
+		_ast.onVisitPost##type(node);\
+		_symbol.onVisitPost##type(node);\
+		if (_resolve_type) { _type.onVisitPost##type(node); }\
+	}
+
+
+namespace ring {
+namespace ringc {
+
+
+// Fused resolver does what AstResolver, SymbolResolver and TypeResolver do, in one traversal.
+// Each of them only looks at what is above a node or at what is before it in preorder, when
+// it is at the node, so at each node the handlers of the three can run one after another: the
+// parent is linked first, then the symbols are bound, and then the type is inferred bottom-up.
+class FusedResolver : public AstVisitor<FusedResolver> {
+	friend class AstVisitor<FusedResolver>;
+
+public:
+	FusedResolver(Resolver* resolver, bool resolve_type);
+
+	// Takes an ast node and start resolving.
+	// The node is linked to `parent`, which is given when it is added to an existing tree.
+	void resolve(AstNode* node, AstNode* parent = NULL);
+
+protected:
+	void onVisitPreNode(AstNode* node) {
+		_ast.onVisitPreNode(node);
+	}
+	void onVisitPostNode(AstNode* node) {
+		_ast.onVisitPostNode(node);
+	}
+
+	FUSED_HANDLERS(Module)
+	FUSED_HANDLERS(Use)
+	FUSED_HANDLERS(Extern)
+	FUSED_HANDLERS(Let)
+	FUSED_HANDLERS(ExprEmpty)
+	FUSED_HANDLERS(ExprBlock)
+	FUSED_HANDLERS(ExprFn)
+	FUSED_HANDLERS(ExprIf)
+	FUSED_HANDLERS(ExprIdent)
+	FUSED_HANDLERS(ExprLiteral)
+	FUSED_HANDLERS(ExprMember)
+	FUSED_HANDLERS(ExprCall)
+	FUSED_HANDLERS(ExprUnary)
+	FUSED_HANDLERS(ExprBinary)
+	FUSED_HANDLERS(ExprLogical)
+	FUSED_HANDLERS(ExprConditional)
+	FUSED_HANDLERS(ExprAssignment)
+
+protected:
+	AstResolver _ast;
+	SymbolResolver _symbol;
+	TypeResolver _type;
+	bool _resolve_type;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+#endif
@@ -7,12 +7,41 @@ using namespace std;
 
 SymbolResolver::SymbolResolver(Resolver* resolver)
 		: _resolver(resolver)
-		, _session(resolver->session()) {
+		, _session(resolver->session())
+		, _visible(SymbolId()) {
 }
 
 
 void SymbolResolver::resolve(AstNode* node) {
+	enterScopes(node->parent());
 	visit(node);
+	leaveScopes();
+}
+
+
+// Enters the existing scopes of `node` and of its ancestors, outermost first.
+// This is the only place the resolver walks up the tree; it is done once per resolve, when a
+// statement is resolved into an already resolved tree.
+void SymbolResolver::enterScopes(AstNode* node) {
+	if (node == NULL) {
+		return;
+	}
+	enterScopes(node->parent());
+	Session* sess = session();
+	if (sess->scope_node_map()->containsR(node->node_id())) {
+		pushScope(node, sess->scope_node_map()->fromR(node->node_id()));
+		_scopes.back().scope->symbol_map().forEach([this](NameId name_id, SymbolId symbol_id) {
+			bindSymbol(name_id, symbol_id);
+		});
+	}
+}
+
+
+// Leaves all the entered scopes.
+void SymbolResolver::leaveScopes() {
+	while (!_scopes.empty()) {
+		popScope();
+	}
 }
 
 
@@ -31,8 +60,9 @@ ScopeId SymbolResolver::newScope(AstNode* node) {
 		assert(scope->node_id() == node->node_id());
 		return scope->scope_id();
 	} else {
-		// There isn't! create new one.
-		Scope* scope = new Scope(sess, NULL, node->node_id());
+		// There isn't! create new one, nested in the innermost scope.
+		Scope* parent = _scopes.empty() ? NULL : _scopes.back().scope;
+		Scope* scope = new Scope(sess, parent, node->node_id());
 		scope->scope_id(sess->scope_table()->add(scope));
 		sess->scope_node_map()->add(scope->scope_id(), node->node_id());
 		return scope->scope_id();
@@ -40,74 +70,101 @@ ScopeId SymbolResolver::newScope(AstNode* node) {
 }
 
 
-// Find most-closely nesting scope of given AST node.
-ScopeId SymbolResolver::findNearestScope(AstNode* node) {
-	// Ast node should not be NULL!
-	assert(node != NULL);
-
-	Session* sess = session();
-	ScopeId scope_id = sess->scope_node_map()->fromR(node->node_id());
-	if (scope_id.some()) {
-		Scope* scope = sess->scope_table()->value(scope_id);
-		assert(scope != NULL && scope->scope_id() == scope_id);
-		return scope->scope_id();
+// Pushes the scope of given AST node onto the scope stack.
+// The frame owner of a scope is the module or function it is the body of, or that of the scope it
+// is nested in.
+void SymbolResolver::pushScope(AstNode* node, ScopeId scope_id) {
+	ScopeEntry entry;
+	entry.scope = session()->scope_table()->value(scope_id);
+	assert(entry.scope != NULL && entry.scope->scope_id() == scope_id);
+	if (node->isModule()) {
+		entry.owner = node;
+	} else if (node->parent() != NULL && node->parent()->isExprFn()) {
+		entry.owner = node->parent();
 	} else {
-		return findNearestScope(node->parent());
+		entry.owner = _scopes.empty() ? NULL : _scopes.back().owner;
 	}
+	entry.shadowed = _shadowed.size();
+	_scopes.push_back(entry);
 }
 
 
-// Find symbol for given name from the most-closely nesting scope of given AST node.
-SymbolId SymbolResolver::findSymbol(AstNode* node, NameId name_id) {
-	if (node == NULL) {
-		// This means that there is no definition for the symbol in this program
-		return -1;
+// Pops the innermost scope, unbinding its symbols.
+void SymbolResolver::popScope() {
+	assert(!_scopes.empty());
+	size_t shadowed = _scopes.back().shadowed;
+	while (_shadowed.size() > shadowed) {
+		_visible.set(_shadowed.back().first, _shadowed.back().second);
+		_shadowed.pop_back();
 	}
+	_scopes.pop_back();
+}
 
-	Session* sess = session();
 
-	// First, find the nearest enclosing scope.
-	ScopeId scope_id = findNearestScope(node);
-	Scope* scope = sess->scope_table()->value(scope_id);
-	assert(scope != NULL);
+// Binds a name to a symbol for the innermost scope.
+// The binding it replaces is remembered, to be restored when the scope is popped.
+void SymbolResolver::bindSymbol(NameId name_id, SymbolId symbol_id) {
+	_shadowed.push_back(make_pair(name_id, _visible.get(name_id)));
+	_visible.set(name_id, symbol_id);
+}
 
-	// Get symbol(AST node id for the definition of this name) from the scope.
-	SymbolId symbol_id = scope->findSymbol(name_id);
-	if (symbol_id.some()) {
-		// If the scope has symbol for the name, returns the ID for the symbol.
-		return symbol_id;
-	} else {
-		// If there is no symbol for this name, find from further scope.
-		// AstNode for current socpe.
-		NodeId node_id = sess->scope_node_map()->fromL(scope->scope_id());
-		assert(node_id.some());
-		AstNode* node = sess->ast_table()->value(node_id);
-		assert(node != NULL);
-		// Resume search from parent node of this scope.
-		return findSymbol(node->parent(), name_id);
-	}
+
+// Find symbol for given name from the scopes on the stack.
+// Returns none if there is no definition for the symbol in this program.
+SymbolId SymbolResolver::findSymbol(NameId name_id) {
+	return _visible.get(name_id);
 }
 
 
-// Add symbol.
-SymbolId SymbolResolver::addSymbol(
-		ScopeId scope_id, NodeId node_id, NameId name_id, TypeId type_id) {
-	assert(scope_id.some() && name_id.some());
+// Add symbol to the innermost scope.
+SymbolId SymbolResolver::addSymbol(NodeId node_id, NameId name_id, TypeId type_id) {
+	assert(!_scopes.empty() && name_id.some());
 
-	Scope* scope = session()->scope_table()->value(scope_id);
+	Scope* scope = _scopes.back().scope;
 
 	// Check if there were the same symbol in the scope.
 	if (scope->findSymbol(name_id).some()) {
-		ERROR("Duplicated symbol: %s", session()->str_table()->value(name_id).c_str());
+		ERROR("Duplicated symbol: %s", session()->str_table()->value(name_id).data());
 		return SymbolId();
 	} else {
-		return scope->addSymbol(node_id, name_id, type_id);
+		SymbolId symbol_id = scope->addSymbol(node_id, name_id, type_id);
+		bindSymbol(name_id, symbol_id);
+		allocSlot(symbol_id);
+		return symbol_id;
+	}
+}
+
+
+// Allocates a frame slot for a symbol defined in the innermost scope.
+// A frame belongs to a function or to the module, so every local of a function gets its own slot
+// in the frame of the function whatever block it is defined in. Arguments get the first slots.
+void SymbolResolver::allocSlot(SymbolId symbol_id) {
+	AstNode* owner = _scopes.back().owner;
+	if (owner == NULL) {
+		FATAL("No function or module for: scope %d", _scopes.back().scope->scope_id());
+	}
+
+	Symbol symbol = session()->symbol_table()->value(symbol_id);
+	symbol.frame_id(owner->node_id());
+	if (owner->isModule()) {
+		Module* module = static_cast<Module*>(owner);
+		symbol.slot(module->frame_size());
+		module->frame_size(module->frame_size() + 1);
+	} else {
+		ExprFn* fn = static_cast<ExprFn*>(owner);
+		symbol.slot(fn->frame_size());
+		fn->frame_size(fn->frame_size() + 1);
 	}
 }
 
 
 void SymbolResolver::onVisitPreModule(Module* module) {
-	newScope(module);
+	pushScope(module, newScope(module));
+}
+
+
+void SymbolResolver::onVisitPostModule(Module* module) {
+	popScope();
 }
 
 
@@ -117,10 +174,8 @@ void SymbolResolver::onVisitPreUse(Use* use) {
 
 void SymbolResolver::processExtern(Extern* ext) {
 	// Add new symbol for this extern on enclosing scope.
-	ScopeId scope_id = findNearestScope(ext);
-	ASSERT(scope_id.some(), "No scope for: extern %d", ext->node_id());
-	SymbolId symbol_id = addSymbol(
-			scope_id, ext->node_id(), ext->name().name_id(), ext->type_id());
+	ASSERT(!_scopes.empty(), "No scope for: extern %d", ext->node_id());
+	SymbolId symbol_id = addSymbol(ext->node_id(), ext->name().name_id(), ext->type_id());
 	ext->name(Ident(ext->name().name_id(), symbol_id));
 }
 
@@ -132,10 +187,8 @@ void SymbolResolver::onVisitPreExtern(Extern* ext) {
 
 void SymbolResolver::processLet(Let* let) {
 	// Add new symbol for this let binding on enclosing scope.
-	ScopeId scope_id = findNearestScope(let);
-	ASSERT(scope_id.some(), "No scope for: let %d", let->node_id());
-	SymbolId symbol_id = addSymbol(
-			scope_id, let->node_id(), let->name().name_id(), let->type_id());
+	ASSERT(!_scopes.empty(), "No scope for: let %d", let->node_id());
+	SymbolId symbol_id = addSymbol(let->node_id(), let->name().name_id(), let->type_id());
 	let->name(Ident(let->name().name_id(), symbol_id));
 }
 
@@ -171,8 +224,7 @@ void SymbolResolver::onVisitPostLet(Let* let) {
 
 void SymbolResolver::onVisitPreExprBlock(ExprBlock* block) {
 	// Block creates new scope.
-	ScopeId scope_id = newScope(block);
-	NodeId block_id = block->node_id();
+	pushScope(block, newScope(block));
 
 	// If this block is a function block, add function arguments symbols to the scope.
 	if (block->parent()->isExprFn()) {
@@ -186,17 +238,21 @@ void SymbolResolver::onVisitPreExprBlock(ExprBlock* block) {
 		for (int i = 0; i < arg_types.size(); ++i) {
 			Ident name = arg_names[i];
 			TypeId type_id = arg_types[i];
-			SymbolId symbol_id = this->addSymbol(scope_id, NodeId(), name.name_id(), type_id);
+			SymbolId symbol_id = this->addSymbol(NodeId(), name.name_id(), type_id);
 			arg_names[i] = Ident(name.name_id(), symbol_id);
 		}
 	}
 }
 
 
+void SymbolResolver::onVisitPostExprBlock(ExprBlock* block) {
+	popScope();
+}
+
 
 void SymbolResolver::onVisitPreExprIdent(ExprIdent* ident) {
 	// Find symbol for this name.
-	SymbolId symbol_id = findSymbol(ident, ident->id().name_id());
+	SymbolId symbol_id = findSymbol(ident->id().name_id());
 	if (symbol_id.some()) {
 		// Set symbol id for this identifier.
 		Ident id = ident->id();
@@ -204,6 +260,7 @@ void SymbolResolver::onVisitPreExprIdent(ExprIdent* ident) {
 		ident->id(id);
 	} else {
 		// There is no symbol for this name. Report it.
-		ERROR("Unresolved name `%s`", session()->str_table()->value(ident->id().name_id()).c_str());
+		ERROR("%s: Unresolved name `%s`", session()->source_map()->location(ident->offset()).c_str(),
+				session()->str_table()->value(ident->id().name_id()).data());
 	}
 }
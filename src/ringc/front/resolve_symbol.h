@@ -11,7 +11,10 @@ namespace ringc {
 #include "../../common.h"
 #include "../syntax/ast_visitor.h"
 #include "../syntax/ast.h"
+#include "../util/id_hash_map.h"
 #include "resolve.h"
+#include <utility>
+#include <vector>
 using namespace ring::ringc::ast;
 
 
@@ -23,7 +26,13 @@ namespace ringc {
 // It takes an AST node and resolves symbols in the subtree rooted from the given node.
 // As result, symbol table on the Session object will be filled with resolved symbol definitions.
 // And each name in the AST node would refers correnct definition node for it.
-class SymbolResolver : public AstVisitor {
+//
+// The scopes enclosing the visited node are kept on a stack. Every name visible there is bound in
+// one flat map from name to symbol, so looking up a name costs a single probe however deeply the
+// scopes are nested. When a scope is left, the bindings its symbols shadowed are put back.
+class SymbolResolver : public AstVisitor<SymbolResolver> {
+	friend class AstVisitor<SymbolResolver>;
+	friend class FusedResolver;
 	ADD_PROPERTY_P(resolver, Resolver)
 	ADD_PROPERTY_P(session, Session)
 
@@ -31,32 +40,61 @@ public:
 	SymbolResolver(Resolver* resolver);
 
 	// Takes an ast node and start resolving.
+	// If the node is already linked into a tree, the scopes enclosing it are entered first.
 	void resolve(AstNode* node);
 
+	// Enters the existing scopes of `node` and of its ancestors, outermost first.
+	void enterScopes(AstNode* node);
+
+	// Leaves all the entered scopes.
+	void leaveScopes();
+
 protected:
 	// Create a new scope for given AST node.
 	ScopeId newScope(AstNode* node);
 
-	// Find most-closely nesting scope of given AST node.
-	ScopeId findNearestScope(AstNode* node);
+	// Pushes the scope of given AST node onto the scope stack.
+	void pushScope(AstNode* node, ScopeId scope_id);
+
+	// Pops the innermost scope, unbinding its symbols.
+	void popScope();
+
+	// Binds a name to a symbol for the innermost scope.
+	void bindSymbol(NameId name_id, SymbolId symbol_id);
 
-	// Find symbol for given name from the most-closely nesting scope of given AST node.
-	SymbolId findSymbol(AstNode* node, NameId name_id);
+	// Find symbol for given name from the scopes on the stack.
+	SymbolId findSymbol(NameId name_id);
 
-	// Add symbol.
-	SymbolId addSymbol(ScopeId scope_id, NodeId node_id, NameId name_id, TypeId type_id);
+	// Add symbol to the innermost scope.
+	SymbolId addSymbol(NodeId node_id, NameId name_id, TypeId type_id);
+
+	// Allocates a frame slot for a symbol defined in the innermost scope.
+	void allocSlot(SymbolId symbol_id);
 
 protected:
 	ADD_VISITOR_PRE(Module);
+	ADD_VISITOR_POST(Module);
 	ADD_VISITOR_PRE(Use);
 	ADD_VISITOR_PRE(Extern);
 	ADD_VISITOR_PRE(Let);
 	ADD_VISITOR_POST(Let);
 	ADD_VISITOR_PRE(ExprBlock);
+	ADD_VISITOR_POST(ExprBlock);
 	ADD_VISITOR_PRE(ExprIdent);
 
 	void processLet(Let* let);
 	void processExtern(Extern* ext);
+
+protected:
+	struct ScopeEntry {
+		Scope* scope;
+		AstNode* owner; // The function or module whose frame holds the symbols of the scope.
+		size_t shadowed; // Size of the shadowed list when the scope was entered.
+	};
+
+	vector<ScopeEntry> _scopes;
+	IdHashMap<NameId, SymbolId> _visible;
+	vector<pair<NameId, SymbolId> > _shadowed;
 };
 
 
@@ -4,9 +4,140 @@ using namespace ring::ringc;
 using namespace std;
 
 
+TypeRules::TypeRules(Session* session)
+		: _session(session) {
+}
+
+
+TypeId TypeRules::typeOfSame(TypeId ty, TypeId of) {
+	if (ty.none()) {
+		return of;
+	}
+	ASSERT_EQ(ty, of, SRCPOS);
+	return ty;
+}
+
+
+TypeId TypeRules::typeOfEmpty(TypeId ty) {
+	if (ty.none()) {
+		return getPrimTypeId(PRIM_TYPE_NIL);
+	}
+	ASSERT_EQ(ty, getPrimTypeId(PRIM_TYPE_INT), SRCPOS);
+	return ty;
+}
+
+
+TypeId TypeRules::typeOfBlock(ExprBlock* block, TypeId ty, bool has_last, bool last_is_expr,
+		TypeId last_ty) {
+	if (ty.some()) {
+		return ty;
+	}
+	if (!has_last) {
+		return getPrimTypeId(PRIM_TYPE_INT);
+	}
+	if (!last_is_expr) {
+		ERROR("Last statement of block MUST be expression - block: %s",
+			session()->ast_str()->toString(block).c_str());
+		return TypeId();
+	}
+	return last_ty;
+}
+
+
+TypeId TypeRules::typeOfFn(TypeId ty) {
+	ASSERT(ty.some(), SRCPOS);
+	return ty;
+}
+
+
+TypeId TypeRules::typeOfIf(ExprIf* if_, TypeId ty, bool has_alt, TypeId con_ty, TypeId alt_ty) {
+	if (ty.some()) {
+		return ty;
+	}
+	if (!has_alt) {
+		return getPrimTypeId(PRIM_TYPE_INT);
+	}
+	if (con_ty != alt_ty) {
+		ERROR("Type of 'then' and 'else' block of 'if' MUST be the same - if: %s",
+				session()->ast_str()->toString(if_).c_str());
+		return getPrimTypeId(PRIM_TYPE_INT);
+	}
+	return con_ty;
+}
+
+
+TypeId TypeRules::typeOfLiteral(TypeId ty, LiteralType lit_type) {
+	if (ty.some()) {
+		return ty;
+	}
+	switch (lit_type) {
+		case LIT_FALSE:
+		case LIT_TRUE:
+			return getPrimTypeId(PRIM_TYPE_BOOL);
+		case LIT_NUM:
+			return getPrimTypeId(PRIM_TYPE_INT);
+		default:
+			return getPrimTypeId(PRIM_TYPE_NIL);
+	}
+}
+
+
+TypeId TypeRules::typeOfCall(TypeId ty, TypeId callee_ty) {
+	if (ty.none() && callee_ty.some()) {
+		FunctionType* fn_ty = session()->type_table()->getFuncType(callee_ty);
+		ASSERT_NE(fn_ty, NULL, SRCPOS);
+		ty = fn_ty->ret();
+	}
+	ASSERT(ty.some(), SRCPOS);
+	return ty;
+}
+
+
+TypeId TypeRules::typeOfBinary(ExprBinary* binary, TypeId ty, TypeId left_ty, TypeId right_ty) {
+	if (ty.some()) {
+		ASSERT_EQ(ty, left_ty, SRCPOS);
+		ASSERT_EQ(ty, right_ty, SRCPOS);
+		return ty;
+	}
+	if (left_ty != right_ty) {
+		ERROR("Type of left and right side of binary expression MUST be the same - binary: %s",
+				session()->ast_str()->toString(binary).c_str());
+		return getPrimTypeId(PRIM_TYPE_NIL);
+	}
+	return left_ty;
+}
+
+
+TypeId TypeRules::typeOfLogical(TypeId ty) {
+	return typeOfSame(ty, getPrimTypeId(PRIM_TYPE_BOOL));
+}
+
+
+TypeId TypeRules::typeOfConditional(ExprConditional* cond, TypeId ty, TypeId con_ty,
+		TypeId alt_ty) {
+	if (ty.some()) {
+		ASSERT_EQ(ty, con_ty, SRCPOS);
+		ASSERT_EQ(ty, alt_ty, SRCPOS);
+		return ty;
+	}
+	if (con_ty != alt_ty) {
+		ERROR("Type of 'con' and 'alt' block of conditional expression MUST be the same - cond: %s",
+				session()->ast_str()->toString(cond).c_str());
+		return getPrimTypeId(PRIM_TYPE_INT);
+	}
+	return con_ty;
+}
+
+
+TypeId TypeRules::getPrimTypeId(const PrimTypeKey& prim_type_key) {
+	return session()->type_table()->getPrimTypeId(prim_type_key);
+}
+
+
 TypeResolver::TypeResolver(Resolver* resolver)
 		: _resolver(resolver)
-		, _session(resolver->session()) {
+		, _session(resolver->session())
+		, _rules(resolver->session()) {
 }
 
 
@@ -16,91 +147,47 @@ void TypeResolver::resolve(AstNode* node) {
 
 
 void TypeResolver::onVisitPostLet(Let* let) {
-	if (let->type_id().none()) {
-		let->type_id(let->expr()->type_id());
-		Symbol* symbol = session()->symbol_table()->value(let->name().symbol_id());
-		symbol->type_id(let->type_id());
-	} else {
-		ASSERT_EQ(let->type_id(), let->expr()->type_id(), SRCPOS);
+	bool infer = let->type_id().none();
+	let->type_id(_rules.typeOfSame(let->type_id(), let->expr()->type_id()));
+	if (infer) {
+		Symbol symbol = session()->symbol_table()->value(let->name().symbol_id());
+		symbol.type_id(let->type_id());
 	}
 }
 
 
 void TypeResolver::onVisitPostExprEmpty(ExprEmpty* empty) {
-	if (empty->type_id().none()) {
-		empty->type_id(getPrimTypeId(PRIM_TYPE_NIL));
-	} else {
-		ASSERT_EQ(empty->type_id(), getPrimTypeId(PRIM_TYPE_INT), SRCPOS);
-	}
+	empty->type_id(_rules.typeOfEmpty(empty->type_id()));
 }
 
 
 void TypeResolver::onVisitPostExprBlock(ExprBlock* block) {
-	if (block->type_id().none()) {
-		if (block->stmts().empty()) {
-			block->type_id(getPrimTypeId(PRIM_TYPE_INT));
-		} else {
-			Stmt* last = block->stmts().back();
-			if (last->isExpr()) {
-				Expr* expr = static_cast<Expr*>(last);
-				block->type_id(expr->type_id());
-			} else {
-				ERROR("Last statement of block MUST be expression - block: %s",
-					session()->ast_str()->toString(block).c_str());
-			}
-		}
-	}
+	Stmt* last = block->stmts().empty() ? NULL : block->stmts().back();
+	bool last_is_expr = last && last->isExpr();
+	TypeId last_ty = last_is_expr ? static_cast<Expr*>(last)->type_id() : TypeId();
+	block->type_id(_rules.typeOfBlock(block, block->type_id(), last != NULL, last_is_expr, last_ty));
 }
 
 
 void TypeResolver::onVisitPostExprFn(ExprFn* fn) {
-	ASSERT(fn->type_id().some(), SRCPOS);
+	_rules.typeOfFn(fn->type_id());
 }
 
 
 void TypeResolver::onVisitPostExprIf(ExprIf* if_) {
-	if (if_->type_id().none()) {
-		if (if_->alt()) {
-			TypeId con_ty = if_->con()->type_id();
-			TypeId alt_ty = if_->alt()->type_id();
-			if (con_ty == alt_ty) {
-				if_->type_id(con_ty);
-			} else {
-				ERROR("Type of 'then' and 'else' block of 'if' MUST be the same - if: %s",
-						session()->ast_str()->toString(if_).c_str());
-				if_->type_id(getPrimTypeId(PRIM_TYPE_INT));
-			}
-		} else {
-			if_->type_id(getPrimTypeId(PRIM_TYPE_INT));
-		}
-	}
+	if_->type_id(_rules.typeOfIf(if_, if_->type_id(), if_->alt() != NULL, if_->con()->type_id(),
+			if_->alt() ? if_->alt()->type_id() : TypeId()));
 }
 
 
 void TypeResolver::onVisitPostExprIdent(ExprIdent* ident) {
-	Symbol* symbol = session()->symbol_table()->value(ident->id().symbol_id());
-	if (ident->type_id().none()) {
-		ident->type_id(symbol->type_id());
-	} else {
-		ASSERT_EQ(ident->type_id(), symbol->type_id(), SRCPOS);
-	}
+	Symbol symbol = session()->symbol_table()->value(ident->id().symbol_id());
+	ident->type_id(_rules.typeOfSame(ident->type_id(), symbol.type_id()));
 }
 
 
 void TypeResolver::onVisitPostExprLiteral(ExprLiteral* literal) {
-	if (literal->type_id().none()) {
-		switch (literal->lit_type()) {
-			case LIT_FALSE:
-			case LIT_TRUE:
-				literal->type_id(getPrimTypeId(PRIM_TYPE_BOOL));
-				break;
-			case LIT_NUM:
-				literal->type_id(getPrimTypeId(PRIM_TYPE_INT));
-				break;
-			default:
-				literal->type_id(getPrimTypeId(PRIM_TYPE_NIL));
-		}
-	}
+	literal->type_id(_rules.typeOfLiteral(literal->type_id(), literal->lit_type()));
 }
 
 
@@ -109,81 +196,32 @@ void TypeResolver::onVisitPostExprMember(ExprMember* member) {
 
 
 void TypeResolver::onVisitPostExprCall(ExprCall* call) {
-	if (call->type_id().none()) {
-		if (call->callee()->type_id().some()) {
-			FunctionType* fn_ty = session()->type_table()->getFuncType(
-					call->callee()->type_id());
-			ASSERT_NE(fn_ty, NULL, SRCPOS);
-			call->type_id(fn_ty->ret());
-		}
-	}
-	ASSERT(call->type_id().some(), SRCPOS);
+	call->type_id(_rules.typeOfCall(call->type_id(), call->callee()->type_id()));
 }
 
 
 void TypeResolver::onVisitPostExprUnary(ExprUnary* unary) {
-	if (unary->type_id().none()) {
-		unary->type_id(unary->expr()->type_id());
-	} else {
-		ASSERT_EQ(unary->type_id(), unary->expr()->type_id(), SRCPOS);
-	}
+	unary->type_id(_rules.typeOfSame(unary->type_id(), unary->expr()->type_id()));
 }
 
 
 void TypeResolver::onVisitPostExprBinary(ExprBinary* binary) {
-	if (binary->type_id().none()) {
-		TypeId ty1 = binary->left()->type_id();
-		TypeId ty2 = binary->right()->type_id();
-		if (ty1 == ty2) {
-			binary->type_id(ty1);
-		} else {
-			ERROR("Type of left and right side of binary expression MUST be the same - binary: %s",
-					session()->ast_str()->toString(binary).c_str());
-			binary->type_id(getPrimTypeId(PRIM_TYPE_NIL));
-		}
-	} else {
-		ASSERT_EQ(binary->type_id(), binary->left()->type_id(), SRCPOS);
-		ASSERT_EQ(binary->type_id(), binary->right()->type_id(), SRCPOS);
-	}
+	binary->type_id(_rules.typeOfBinary(binary, binary->type_id(), binary->left()->type_id(),
+			binary->right()->type_id()));
 }
 
 
 void TypeResolver::onVisitPostExprLogical(ExprLogical* logical) {
-	if (logical->type_id().none()) {
-		logical->type_id(getPrimTypeId(PRIM_TYPE_BOOL));
-	} else {
-		ASSERT_EQ(logical->type_id(), getPrimTypeId(PRIM_TYPE_BOOL), SRCPOS);
-	}
+	logical->type_id(_rules.typeOfLogical(logical->type_id()));
 }
 
 
 void TypeResolver::onVisitPostExprConditional(ExprConditional* cond) {
-	if (cond->type_id().none()) {
-		TypeId con_ty = cond->con()->type_id();
-		TypeId alt_ty = cond->alt()->type_id();
-		if (con_ty == alt_ty) {
-			cond->type_id(con_ty);
-		} else {
-			ERROR("Type of 'con' and 'alt' block of conditional expression MUST be the same - cond: %s",
-					session()->ast_str()->toString(cond).c_str());
-			cond->type_id(getPrimTypeId(PRIM_TYPE_INT));
-		}
-	} else {
-		ASSERT_EQ(cond->type_id(), cond->con()->type_id(), SRCPOS);
-		ASSERT_EQ(cond->type_id(), cond->alt()->type_id(), SRCPOS);
-	}
+	cond->type_id(_rules.typeOfConditional(cond, cond->type_id(), cond->con()->type_id(),
+			cond->alt()->type_id()));
 }
 
 
 void TypeResolver::onVisitPostExprAssignment(ExprAssignment* assign) {
-	if (assign->type_id().none()) {
-		assign->type_id(assign->left()->type_id());
-	} else {
-		ASSERT_EQ(assign->type_id(), assign->left()->type_id(), SRCPOS);
-	}
+	assign->type_id(_rules.typeOfSame(assign->type_id(), assign->left()->type_id()));
 }
-
-
-TypeId TypeResolver::getPrimTypeId(const PrimTypeKey& prim_type_key) {
-	return session()->type_table()->getPrimTypeId(prim_type_key);
-}
\ No newline at end of file
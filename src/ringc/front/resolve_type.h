@@ -18,7 +18,38 @@ namespace ring {
 namespace ringc {
 
 
-class TypeResolver : public AstVisitor{
+// TypeRules are the typing rules, shared by TypeResolver and FlatTypeResolver.
+// Each rule takes the type a node already has, none if it has not, and the types of its children,
+// and returns the type of the node. A type the node already has is checked, not changed. The node
+// itself is passed only to be shown in errors.
+class TypeRules {
+	ADD_PROPERTY_P(session, Session)
+
+public:
+	TypeRules(Session* session);
+
+	// Type of a node which has the type of one of its children, or of its symbol:
+	// let, ident, unary and assignment.
+	TypeId typeOfSame(TypeId ty, TypeId of);
+
+	TypeId typeOfEmpty(TypeId ty);
+	TypeId typeOfBlock(ExprBlock* block, TypeId ty, bool has_last, bool last_is_expr,
+			TypeId last_ty);
+	TypeId typeOfFn(TypeId ty);
+	TypeId typeOfIf(ExprIf* if_, TypeId ty, bool has_alt, TypeId con_ty, TypeId alt_ty);
+	TypeId typeOfLiteral(TypeId ty, LiteralType lit_type);
+	TypeId typeOfCall(TypeId ty, TypeId callee_ty);
+	TypeId typeOfBinary(ExprBinary* binary, TypeId ty, TypeId left_ty, TypeId right_ty);
+	TypeId typeOfLogical(TypeId ty);
+	TypeId typeOfConditional(ExprConditional* cond, TypeId ty, TypeId con_ty, TypeId alt_ty);
+
+	TypeId getPrimTypeId(const PrimTypeKey& prim_type_key);
+};
+
+
+class TypeResolver : public AstVisitor<TypeResolver> {
+	friend class AstVisitor<TypeResolver>;
+	friend class FusedResolver;
 	ADD_PROPERTY_P(resolver, Resolver)
 	ADD_PROPERTY_P(session, Session)
 
@@ -43,7 +74,8 @@ protected:
 	ADD_VISITOR_POST(ExprConditional);
 	ADD_VISITOR_POST(ExprAssignment);
 
-	TypeId getPrimTypeId(const PrimTypeKey& prim_type_key);
+protected:
+	TypeRules _rules;
 };
 
 
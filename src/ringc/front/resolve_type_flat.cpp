@@ -0,0 +1,115 @@
+#include "resolve_type_flat.h"
+using namespace ring::ringc;
+using namespace std;
+
+
+FlatTypeResolver::FlatTypeResolver(Resolver* resolver)
+		: _resolver(resolver)
+		, _session(resolver->session())
+		, _rules(resolver->session())
+		, _flat(NULL) {
+}
+
+
+void FlatTypeResolver::resolve(FlatAst* flat) {
+	_flat = flat;
+	visit(*flat);
+}
+
+
+// The children of each kind are laid out as AstVisitor visits them; see FlatAst.
+void FlatTypeResolver::onVisitPost(const FlatAst& flat, FlatIndex ix) {
+	TypeId ty = flat.type_id(ix);
+	switch (flat.kind(ix)) {
+		case AST_LET:
+			resolveLet(ix);
+			break;
+		case AST_EXPR_EMPTY:
+			setTypeId(ix, _rules.typeOfEmpty(ty));
+			break;
+		case AST_EXPR_BLOCK:
+			resolveExprBlock(ix);
+			break;
+		case AST_EXPR_FN:
+			_rules.typeOfFn(ty);
+			break;
+		case AST_EXPR_IF:
+			setTypeId(ix, _rules.typeOfIf(static_cast<ExprIf*>(node(ix)), ty, flat.sub(ix) != 0,
+					childTypeId(ix, 1), childTypeId(ix, 2)));
+			break;
+		case AST_EXPR_IDENT:
+			setTypeId(ix, _rules.typeOfSame(ty,
+					session()->symbol_table()->value(flat.symbol_id(ix)).type_id()));
+			break;
+		case AST_EXPR_LITERAL:
+			setTypeId(ix, _rules.typeOfLiteral(ty, (LiteralType)flat.sub(ix)));
+			break;
+		case AST_EXPR_CALL:
+			setTypeId(ix, _rules.typeOfCall(ty, childTypeId(ix, 0)));
+			break;
+		case AST_EXPR_UNARY:
+		case AST_EXPR_ASSIGNMENT:
+			setTypeId(ix, _rules.typeOfSame(ty, childTypeId(ix, 0)));
+			break;
+		case AST_EXPR_BINARY:
+			setTypeId(ix, _rules.typeOfBinary(static_cast<ExprBinary*>(node(ix)), ty,
+					childTypeId(ix, 0), childTypeId(ix, 1)));
+			break;
+		case AST_EXPR_LOGICAL:
+			setTypeId(ix, _rules.typeOfLogical(ty));
+			break;
+		case AST_EXPR_CONDITIONAL:
+			setTypeId(ix, _rules.typeOfConditional(static_cast<ExprConditional*>(node(ix)), ty,
+					childTypeId(ix, 1), childTypeId(ix, 2)));
+			break;
+		default:
+			break;
+	}
+}
+
+
+void FlatTypeResolver::resolveLet(FlatIndex ix) {
+	bool infer = _flat->type_id(ix).none();
+	setTypeId(ix, _rules.typeOfSame(_flat->type_id(ix), childTypeId(ix, 0)));
+	if (infer) {
+		Symbol symbol = session()->symbol_table()->value(_flat->symbol_id(ix));
+		symbol.type_id(_flat->type_id(ix));
+	}
+}
+
+
+void FlatTypeResolver::resolveExprBlock(FlatIndex ix) {
+	FlatIndex last = FLAT_NONE;
+	for (FlatIndex c = _flat->firstChild(ix); c != FLAT_NONE; c = _flat->nextSibling(c)) {
+		last = c;
+	}
+	bool last_is_expr = last != FLAT_NONE &&
+		_flat->kind(last) >= AST_EXPR_EMPTY && _flat->kind(last) <= AST_EXPR_ASSIGNMENT;
+	setTypeId(ix, _rules.typeOfBlock(static_cast<ExprBlock*>(node(ix)), _flat->type_id(ix),
+			last != FLAT_NONE, last_is_expr, last_is_expr ? _flat->type_id(last) : TypeId()));
+}
+
+
+void FlatTypeResolver::setTypeId(FlatIndex ix, TypeId type_id) {
+	if (_flat->type_id(ix) == type_id) {
+		return;
+	}
+	_flat->type_id(ix, type_id);
+	AstNode* n = node(ix);
+	if (n->isExpr()) {
+		static_cast<Expr*>(n)->type_id(type_id);
+	} else if (n->isLet()) {
+		static_cast<Let*>(n)->type_id(type_id);
+	}
+}
+
+
+TypeId FlatTypeResolver::childTypeId(FlatIndex ix, FlatIndex n) {
+	FlatIndex c = _flat->child(ix, n);
+	return c != FLAT_NONE ? _flat->type_id(c) : TypeId();
+}
+
+
+AstNode* FlatTypeResolver::node(FlatIndex ix) {
+	return session()->ast_table()->value(_flat->node_id(ix));
+}
@@ -0,0 +1,57 @@
+#ifndef RING_RINGC_FRONT_RESOLVE_TYPE_FLAT_H
+#define RING_RINGC_FRONT_RESOLVE_TYPE_FLAT_H
+
+
+namespace ring {
+namespace ringc {
+	class FlatTypeResolver;
+}}
+
+
+#include "../../common.h"
+#include "../syntax/ast.h"
+#include "../syntax/flat_ast.h"
+#include "resolve.h"
+#include "resolve_type.h"
+using namespace ring::ringc::ast;
+
+
+namespace ring {
+namespace ringc {
+
+
+// FlatTypeResolver does what TypeResolver does, on the flat AST of the module.
+// It applies the same TypeRules, but reads the types of the children from the type column, so a
+// node is typed without touching the nodes under it. Each type found is stored in the column and
+// on the AST node it came from.
+class FlatTypeResolver : public FlatAstVisitor {
+	ADD_PROPERTY_P(resolver, Resolver)
+	ADD_PROPERTY_P(session, Session)
+
+public:
+	FlatTypeResolver(Resolver* resolver);
+
+	void resolve(FlatAst* flat);
+
+protected:
+	virtual void onVisitPost(const FlatAst& flat, FlatIndex ix);
+
+	void resolveLet(FlatIndex ix);
+	void resolveExprBlock(FlatIndex ix);
+
+	// Stores the type of the node at `ix` in the column and on the AST node.
+	void setTypeId(FlatIndex ix, TypeId type_id);
+	TypeId childTypeId(FlatIndex ix, FlatIndex n);
+	AstNode* node(FlatIndex ix);
+
+protected:
+	TypeRules _rules;
+	FlatAst* _flat;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
@@ -0,0 +1,128 @@
+#include "resolve_verify.h"
+#include "parser.h"
+#include "resolve.h"
+#include <algorithm>
+#include <cstdio>
+using namespace ring::ringc;
+using namespace std;
+
+
+ResolveVerifier::ResolveVerifier(Session* session)
+		: _session(session) {
+}
+
+
+bool ResolveVerifier::verify(Module* module) {
+	PhaseTimer timer(session(), "resolve.verify");
+	llvm::StringRef text = session()->source_map()->text(module->offset());
+	if (text.empty() || session()->diagnostic()->mostSignificantLevel() <= REPORT_ERROR) {
+		return true;
+	}
+
+	// The other session resolves by the other path, and reports nothing of its own.
+	Config config(*session()->config());
+	config.fused_resolve(!config.fused_resolve());
+	config.verify_resolve(false);
+	config.time_report(false);
+	config.stats(false);
+	config.trace_file("");
+	Session other(&config);
+	Parser parser(text.str(), &other);
+	Module* other_module = parser.parseProgram();
+	if (other.diagnostic()->mostSignificantLevel() > REPORT_ERROR) {
+		Resolver resolver(&other);
+		resolver.resolve(other_module);
+	}
+	if (other.diagnostic()->mostSignificantLevel() <= REPORT_ERROR) {
+		ERROR("%s", "Module does not resolve again by the other resolver");
+		return false;
+	}
+
+	Tree tree, other_tree;
+	build(session(), module, &tree);
+	build(&other, other_module, &other_tree);
+	const Tree& fused = config.fused_resolve() ? other_tree : tree;
+	const Tree& passes = config.fused_resolve() ? tree : other_tree;
+
+	FlatIndex length = max(tree.flat.length(), other_tree.flat.length());
+	for (FlatIndex ix = 0; ix < length; ++ix) {
+		string fused_desc = ix < fused.flat.length() ? describe(fused, ix) : "none";
+		string passes_desc = ix < passes.flat.length() ? describe(passes, ix) : "none";
+		if (fused_desc != passes_desc) {
+			uint32_t offset = module->offset();
+			if (ix < tree.flat.length()) {
+				offset = session()->ast_table()->value(tree.flat.node_id(ix))->offset();
+			}
+			ERROR("Fused resolver differs from resolver passes at node %d (%s) - fused: %s, passes: %s",
+					(int)ix, session()->source_map()->location(offset).c_str(),
+					fused_desc.c_str(), passes_desc.c_str());
+			return false;
+		}
+	}
+	if (index(fused, fused.session->main()) != index(passes, passes.session->main())) {
+		ERROR("Fused resolver differs from resolver passes on main - fused: node %d, passes: node %d",
+				index(fused, fused.session->main()), index(passes, passes.session->main()));
+		return false;
+	}
+	return true;
+}
+
+
+void ResolveVerifier::build(Session* session, Module* module, Tree* tree) {
+	tree->session = session;
+	FlatAstBuilder builder(&tree->flat);
+	builder.build(module);
+	tree->indices.assign(session->ast_table()->length(), FLAT_NONE);
+	for (FlatIndex ix = 0; ix < tree->flat.length(); ++ix) {
+		tree->indices[tree->flat.node_id(ix).value()] = ix;
+	}
+}
+
+
+string ResolveVerifier::describe(const Tree& tree, FlatIndex ix) {
+	const FlatAst& flat = tree.flat;
+	AstNode* node = tree.session->ast_table()->value(flat.node_id(ix));
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "kind %d parent %d", (int)flat.kind(ix),
+			node->parent() ? index(tree, node->parent()->node_id()) : -1);
+	string res = buffer;
+	if (flat.type_id(ix).some()) {
+		res += " type " + tree.session->ast_str()->toString(flat.type_id(ix));
+	}
+	if (flat.symbol_id(ix).some()) {
+		res += " symbol " + describeSymbol(tree, flat.symbol_id(ix));
+	}
+	if (flat.kind(ix) == AST_MODULE) {
+		snprintf(buffer, sizeof(buffer), " frame_size %d", static_cast<Module*>(node)->frame_size());
+		res += buffer;
+	} else if (flat.kind(ix) == AST_EXPR_FN) {
+		snprintf(buffer, sizeof(buffer), " frame_size %d", static_cast<ExprFn*>(node)->frame_size());
+		res += buffer;
+		for (int n = 0; n < flat.name(ix); ++n) {
+			res += " arg " + describeSymbol(tree, flat.arg(ix, n).symbol_id());
+		}
+	}
+	return res;
+}
+
+
+// A symbol is told by its name, the nodes it is defined at and scoped in, its slot and its type.
+string ResolveVerifier::describeSymbol(const Tree& tree, SymbolId symbol_id) {
+	Symbol symbol = tree.session->symbol_table()->value(symbol_id);
+	Scope* scope = tree.session->scope_table()->value(symbol.scope_id());
+	char buffer[96];
+	snprintf(buffer, sizeof(buffer), "(node %d scope %d frame %d slot %d) ",
+			index(tree, symbol.node_id()), scope ? index(tree, scope->node_id()) : -1,
+			index(tree, symbol.frame_id()), symbol.slot());
+	return tree.session->str(symbol.name_id()).str() + buffer +
+		tree.session->ast_str()->toString(symbol.type_id());
+}
+
+
+int ResolveVerifier::index(const Tree& tree, NodeId node_id) {
+	if (node_id.none() || node_id.value() >= (int)tree.indices.size() ||
+			tree.indices[node_id.value()] == FLAT_NONE) {
+		return -1;
+	}
+	return tree.indices[node_id.value()];
+}
@@ -0,0 +1,60 @@
+#ifndef RING_RINGC_FRONT_RESOLVE_VERIFY_H
+#define RING_RINGC_FRONT_RESOLVE_VERIFY_H
+
+
+namespace ring {
+namespace ringc {
+	class ResolveVerifier;
+}}
+
+
+#include <string>
+#include <vector>
+#include "../../common.h"
+#include "../session/session.h"
+#include "../syntax/ast.h"
+#include "../syntax/flat_ast.h"
+using namespace ring::ringc::ast;
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// ResolveVerifier checks that the fused resolver and the separate passes resolve a module alike.
+// The source of the module is parsed again into a session of its own, and resolved there by the
+// other path. The two trees are then compared node by node in preorder: kinds, parents, types,
+// symbols and frame sizes. Since ids of one session mean nothing in the other, nodes are named by
+// their preorder index, and types and symbols by what they are.
+class ResolveVerifier {
+	ADD_PROPERTY_P(session, Session)
+
+public:
+	ResolveVerifier(Session* session);
+
+	// Reports the first node of `module` which the other path resolves differently.
+	// Returns false if there is one; a module whose source can not be found is not checked.
+	bool verify(Module* module);
+
+protected:
+	struct Tree {
+		Session* session;
+		FlatAst flat;
+		vector<FlatIndex> indices; // Preorder index of each node id.
+	};
+
+	void build(Session* session, Module* module, Tree* tree);
+
+	// Returns a line describing how the node at `ix` is resolved.
+	string describe(const Tree& tree, FlatIndex ix);
+	string describeSymbol(const Tree& tree, SymbolId symbol_id);
+	int index(const Tree& tree, NodeId node_id);
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
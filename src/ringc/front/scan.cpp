@@ -0,0 +1,146 @@
+#include "scan.h"
+#include "reader.h"
+#include <stdint.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+using namespace ring::ringc;
+
+
+// A vector of the widest width available. Each of the classifiers returns a mask of the bytes
+// which are in the class, a bit per byte.
+#if defined(__AVX2__)
+
+#define SCAN_WIDTH 32
+typedef __m256i ScanVec;
+
+static inline ScanVec load(const char* p) {
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+static inline ScanVec splat(char ch) { return _mm256_set1_epi8(ch); }
+static inline ScanVec eq(ScanVec a, ScanVec b) { return _mm256_cmpeq_epi8(a, b); }
+static inline ScanVec gt(ScanVec a, ScanVec b) { return _mm256_cmpgt_epi8(a, b); }
+static inline ScanVec add(ScanVec a, ScanVec b) { return _mm256_add_epi8(a, b); }
+static inline ScanVec or_(ScanVec a, ScanVec b) { return _mm256_or_si256(a, b); }
+static inline uint32_t mask(ScanVec v) { return (uint32_t)_mm256_movemask_epi8(v); }
+
+#elif defined(__SSE2__)
+
+#define SCAN_WIDTH 16
+typedef __m128i ScanVec;
+
+static inline ScanVec load(const char* p) {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+static inline ScanVec splat(char ch) { return _mm_set1_epi8(ch); }
+static inline ScanVec eq(ScanVec a, ScanVec b) { return _mm_cmpeq_epi8(a, b); }
+static inline ScanVec gt(ScanVec a, ScanVec b) { return _mm_cmpgt_epi8(a, b); }
+static inline ScanVec add(ScanVec a, ScanVec b) { return _mm_add_epi8(a, b); }
+static inline ScanVec or_(ScanVec a, ScanVec b) { return _mm_or_si128(a, b); }
+static inline uint32_t mask(ScanVec v) { return (uint32_t)_mm_movemask_epi8(v); }
+
+#endif
+
+
+#ifdef SCAN_WIDTH
+
+static const uint32_t FullMask = SCAN_WIDTH == 32 ? 0xffffffffu : 0xffffu;
+
+// Bytes in [lo, lo + n) for a signed byte compare: the range is shifted to begin at -128, so
+// every byte out of it compares greater than -128 + n - 1.
+static inline ScanVec inRange(ScanVec v, char lo, int n) {
+	ScanVec shifted = add(v, splat((char)(0x80 - lo)));
+	return gt(splat((char)(-128 + n)), shifted);
+}
+
+static inline uint32_t whitespaceMask(ScanVec v) {
+	return mask(or_(or_(eq(v, splat(' ')), eq(v, splat('\t'))),
+			or_(eq(v, splat('\n')), eq(v, splat('\r')))));
+}
+
+static inline uint32_t digitMask(ScanVec v) {
+	return mask(inRange(v, '0', 10));
+}
+
+// Lower casing by setting 0x20 maps only the upper case letters onto the lower case ones.
+static inline uint32_t identMask(ScanVec v) {
+	ScanVec lower = or_(v, splat(0x20));
+	return mask(or_(or_(inRange(lower, 'a', 26), inRange(v, '0', 10)), eq(v, splat('_'))));
+}
+
+// Counts the leading chunks whose bytes are all in the class. Returns the number of bytes, and
+// stops at the first chunk which is not full or which would cross `len`.
+#define SCAN_RUN(MASK_FN) \
+	size_t ix = 0;\
+	for (; ix + SCAN_WIDTH <= len; ix += SCAN_WIDTH) {\
+		uint32_t m = MASK_FN(load(src + ix));\
+		if (m != FullMask) {\
+			return ix + __builtin_ctz(~m);\
+		}\
+	}
+
+#else
+
+#define SCAN_RUN(MASK_FN) \
+	size_t ix = 0;
+
+#endif
+
+
+size_t ScanUtil::whitespaceRun(const char* src, size_t len) {
+	SCAN_RUN(whitespaceMask)
+	while (ix < len && LexUtil::isWhitespace(src[ix])) {
+		++ix;
+	}
+	return ix;
+}
+
+
+size_t ScanUtil::identRun(const char* src, size_t len) {
+	SCAN_RUN(identMask)
+	while (ix < len && LexUtil::isIdentContinue(src[ix])) {
+		++ix;
+	}
+	return ix;
+}
+
+
+size_t ScanUtil::digitRun(const char* src, size_t len) {
+	SCAN_RUN(digitMask)
+	while (ix < len && LexUtil::isDecimalDigit(src[ix])) {
+		++ix;
+	}
+	return ix;
+}
+
+
+// Each set bit of the newline mask of a chunk is a line start after it.
+void ScanUtil::lineStarts(const char* src, size_t len, vector<uint32_t>* starts) {
+	size_t ix = 0;
+#ifdef SCAN_WIDTH
+	for (; ix + SCAN_WIDTH <= len; ix += SCAN_WIDTH) {
+		uint32_t m = mask(eq(load(src + ix), splat('\n')));
+		while (m != 0) {
+			starts->push_back(ix + __builtin_ctz(m) + 1);
+			m &= m - 1;
+		}
+	}
+#endif
+	for (; ix < len; ++ix) {
+		if (src[ix] == '\n') {
+			starts->push_back(ix + 1);
+		}
+	}
+}
+
+
+// Hex literals are short, so they are scanned a byte at a time.
+size_t ScanUtil::hexDigitRun(const char* src, size_t len) {
+	size_t ix = 0;
+	while (ix < len && LexUtil::isHexDigit(src[ix])) {
+		++ix;
+	}
+	return ix;
+}
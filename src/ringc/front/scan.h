@@ -0,0 +1,42 @@
+#ifndef RING_RINGC_FRONT_SCAN_H
+#define RING_RINGC_FRONT_SCAN_H
+
+
+namespace ring {
+namespace ringc {
+	class ScanUtil;
+}}
+
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// ScanUtil measures runs of characters of a class, 32 bytes at a time with AVX2 or 16 bytes at a
+// time with SSE2, and a byte at a time otherwise.
+// Each returns the number of leading characters of `src[0, len)` in the class. The classes are
+// those of LexUtil, and bytes out of ASCII are in none of them.
+class ScanUtil {
+public:
+	static size_t whitespaceRun(const char* src, size_t len);
+	static size_t identRun(const char* src, size_t len);
+	static size_t digitRun(const char* src, size_t len);
+	static size_t hexDigitRun(const char* src, size_t len);
+
+	// Appends the offset of the start of every line after the first, that is the offset after
+	// every '\n', to `starts`.
+	static void lineStarts(const char* src, size_t len, vector<uint32_t>* starts);
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
@@ -9,7 +9,7 @@ Scope::Scope(Session* session, Scope* parent, NodeId node_id)
 		, _node_id(node_id)
 		, _parent(parent)
 		, _session(session)
-		, _symbol_map(NameId(), SymbolId())
+		, _symbol_map(SymbolId())
 		, _llvm_bb(NULL) {
 }
 
@@ -20,17 +20,15 @@ bool Scope::isTopmost() const {
 
 
 SymbolId Scope::addSymbol(NodeId node_id, NameId name_id, TypeId type_id) {
-	assert(!_symbol_map.containsL(name_id));
+	assert(!_symbol_map.contains(name_id));
 	// create new symbol and add it to symbol table.
-	Symbol* new_symbol = new Symbol(node_id, name_id, _scope_id, type_id);
-	SymbolId id = session()->symbol_table()->add(new_symbol);
-	new_symbol->id(id);
+	SymbolId id = session()->symbol_table()->add(node_id, name_id, _scope_id, type_id);
 	// add the symbol to this scope.
-	_symbol_map.add(name_id, id);
+	_symbol_map.set(name_id, id);
 	return id;
 }
 
 
 SymbolId Scope::findSymbol(NameId name_id) {
-	return _symbol_map.fromL(name_id);
+	return _symbol_map.get(name_id);
 }
@@ -11,6 +11,7 @@ namespace ringc {
 #include "../../common.h"
 #include "../syntax/ast.h"
 #include "../session/session.h"
+#include "../util/id_hash_map.h"
 #include "symbol.h"
 using namespace ring::ringc::ast;
 
@@ -21,7 +22,7 @@ namespace ring {
 namespace ringc {
 
 // Mapping between name and symbol which is AST node where the name is defined.
-typedef BiMap<NameId, SymbolId> NameSymbolMap;
+typedef IdHashMap<NameId, SymbolId> NameSymbolMap;
 
 // A Scope represent lexical scope region of source program.
 // Ring language's lexical scope depends on block structure. It means each block generates a new
@@ -33,7 +34,7 @@ class Scope {
 	ADD_PROPERTY(node_id, NodeId) // AST node id corresponding to this scope.
 	ADD_PROPERTY_P(parent, Scope) // Pointer to parent scope, NULL if this is topmost.
 	ADD_PROPERTY_P(session, Session)
-	ADD_PROPERTY_R(symbol_map, NameSymbolMap) // A bi-map between name id and symbol.
+	ADD_PROPERTY_R(symbol_map, NameSymbolMap) // A map from name id to symbol.
 	ADD_PROPERTY_P(llvm_bb, llvm::BasicBlock)
 
 public:
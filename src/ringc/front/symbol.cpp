@@ -3,11 +3,35 @@ using namespace ring::ringc;
 
 
 
-Symbol::Symbol(NodeId node_id, NameId name_id, ScopeId scope_id, TypeId type_id)
-		: _id()
-		, _node_id(node_id)
-		, _name_id(name_id)
-		, _scope_id(scope_id)
-		, _type_id(type_id)
-		, _llvm_val(NULL) {
+SymbolTable::SymbolTable() {
+	add(NodeId(), NameId(), ScopeId(), TypeId());
+}
+
+
+SymbolId SymbolTable::add(NodeId node_id, NameId name_id, ScopeId scope_id, TypeId type_id) {
+	_node_ids.push_back(node_id);
+	_name_ids.push_back(name_id);
+	_scope_ids.push_back(scope_id);
+	_type_ids.push_back(type_id);
+	_frame_ids.push_back(NodeId());
+	_slots.push_back(-1);
+	_llvm_vals.push_back(NULL);
+	return SymbolId(length() - 1);
+}
+
+
+Symbol SymbolTable::value(SymbolId id) {
+	if (id.value() < 0 || id.value() >= length()) {
+		return Symbol(this, 0);
+	} else {
+		return Symbol(this, id);
+	}
+}
+
+
+size_t SymbolTable::memoryUsage() const {
+	return _node_ids.capacity() * sizeof(NodeId) + _name_ids.capacity() * sizeof(NameId) +
+		_scope_ids.capacity() * sizeof(ScopeId) + _type_ids.capacity() * sizeof(TypeId) +
+		_frame_ids.capacity() * sizeof(NodeId) + _slots.capacity() * sizeof(int) +
+		_llvm_vals.capacity() * sizeof(llvm::Value*);
 }
@@ -5,31 +5,85 @@
 namespace ring {
 namespace ringc {
 	class Symbol;
+	class SymbolTable;
 }}
 
 
 #include "../../common.h"
 #include "../syntax/ast.h"
 #include "../session/session.h"
+#include <vector>
 using namespace ring::ringc::ast;
+using namespace std;
 
 #include "llvm/IR/Value.h"
 
 
+// Defines getter and setter of a symbol field kept in a column of the symbol table.
+#define ADD_SYMBOL_FIELD(name, type)\
+	public:\
+		type name() const { return _table->_##name##s[_id.value()]; }\
+		void name(type v) { _table->_##name##s[_id.value()] = v; }
+
+
 namespace ring {
 namespace ringc {
 
 
+// SymbolTable is an append-only table of symbols, stored as a structure of arrays: each field of
+// the symbols is a column indexed by symbol id, so a pass reading one field touches only it.
+// Id 0 is a placeholder, which value() returns for an unknown id.
+class SymbolTable {
+	friend class Symbol;
+
+public:
+	SymbolTable();
+
+	// Returns the number of symbols, including the placeholder.
+	int length() const { return _node_ids.size(); }
+
+	// Adds a symbol and returns its id.
+	SymbolId add(NodeId node_id, NameId name_id, ScopeId scope_id, TypeId type_id);
+
+	// Returns the symbol for the id.
+	Symbol value(SymbolId id);
+
+	// Returns the bytes of the columns.
+	size_t memoryUsage() const;
+
+protected:
+	vector<NodeId> _node_ids;
+	vector<NameId> _name_ids;
+	vector<ScopeId> _scope_ids;
+	vector<TypeId> _type_ids;
+	vector<NodeId> _frame_ids;
+	vector<int> _slots;
+	vector<llvm::Value*> _llvm_vals;
+};
+
+
+// Symbol is a handle to a symbol in the symbol table. It is cheap to copy, and its fields read
+// and write the columns of the table.
 class Symbol {
-	ADD_PROPERTY(id, SymbolId)
-	ADD_PROPERTY(node_id, NodeId)
-	ADD_PROPERTY(name_id, NameId)
-	ADD_PROPERTY(scope_id, ScopeId)
-	ADD_PROPERTY(type_id, TypeId)
-	ADD_PROPERTY_P(llvm_val, llvm::Value)
+	ADD_SYMBOL_FIELD(node_id, NodeId)
+	ADD_SYMBOL_FIELD(name_id, NameId)
+	ADD_SYMBOL_FIELD(scope_id, ScopeId)
+	ADD_SYMBOL_FIELD(type_id, TypeId)
+	ADD_SYMBOL_FIELD(frame_id, NodeId) // Function or module whose frame holds this symbol.
+	ADD_SYMBOL_FIELD(slot, int) // Index in the frame, -1 if not allocated.
+	ADD_SYMBOL_FIELD(llvm_val, llvm::Value*)
 
 public:
-	Symbol(NodeId node_id, NameId name_id, ScopeId scope_id, TypeId type_id);
+	Symbol(SymbolTable* table, SymbolId id) : _table(table), _id(id) {}
+
+	SymbolId id() const { return _id; }
+
+	// Returns false for the placeholder, which the table gives for an unknown id.
+	bool isValid() const { return _id.value() > 0; }
+
+protected:
+	SymbolTable* _table;
+	SymbolId _id;
 };
 
 
@@ -5,19 +5,19 @@ using namespace ring::ringc;
 
 
 AstTable::AstTable(Session* session)
-		: TableMap<NodeId, AstNode*>(NULL)
+		: IdTable<NodeId, AstNode*>(NULL)
 		, _session(session) {
 }
 
 
+// The nodes live in the AST arena of the session, which releases them all at once.
 AstTable::~AstTable() {
-	for_each(begin(), end(), [](AstNode* node) { delete node; });
 }
 
 
 NodeId AstTable::add(AstNode* node) {
 	ASSERT(node->node_id().none(), SRCPOS);
-	NodeId id = TableMap<NodeId, AstNode*>::add(node);
+	NodeId id = IdTable<NodeId, AstNode*>::add(node);
 	node->node_id(id);
 	return id;
 }
@@ -9,7 +9,7 @@ namespace ringc {
 
 
 #include "../../common.h"
-#include "../util/table_map.h"
+#include "../util/id_table.h"
 #include "../syntax/ast.h"
 #include "session.h"
 using namespace ring::ringc;
@@ -20,7 +20,7 @@ namespace ring {
 namespace ringc {
 
 
-class AstTable : public TableMap<NodeId, AstNode*> {
+class AstTable : public IdTable<NodeId, AstNode*> {
 	ADD_PROPERTY_P(session, Session);
 public:
 	AstTable(Session* session);
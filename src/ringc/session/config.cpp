@@ -1,5 +1,7 @@
 #include "config.h"
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <algorithm>
 using namespace ring::ringc;
@@ -22,7 +24,20 @@ Config::Config()
 		, _print_ast(false)
 		, _log_level(LOG_INFO)
 		, _linker("g++")
-		, _link_opt("-lringrt") {
+		, _link_opt("-lringrt")
+		, _use_vm(true)
+		, _print_bytecode(false)
+		, _print_quickened(false)
+		, _gc_stats(false)
+		, _gc_threshold(1024 * 1024)
+		, _jit(true)
+		, _jit_threshold(1000)
+		, _jit_perf_map(false)
+		, _time_report(false)
+		, _stats(false)
+		, _fused_resolve(true)
+		, _verify_resolve(false)
+		, _trace_file("") {
 }
 
 
@@ -41,13 +56,34 @@ void Config::parseArgument(char* arg) {
 				fprintf(stderr, "ringci: log-level should be one of: INFO, DEBUG, TRACE\n");
 			}
 		} else if (res.first == "print-ast") {
-			if (res.second == "" || res.second == "true") {
-				print_ast(true);
-			} else if (res.second == "false") {
-				print_ast(false);
-			} else {
-				fprintf(stderr, "ringci: log-level should be one of: TRUE, FLASE\n");
-			}
+			parseBoolArgument(res.first, res.second, &_print_ast);
+		} else if (res.first == "use-vm") {
+			parseBoolArgument(res.first, res.second, &_use_vm);
+		} else if (res.first == "print-bytecode") {
+			parseBoolArgument(res.first, res.second, &_print_bytecode);
+		} else if (res.first == "print-quickened") {
+			parseBoolArgument(res.first, res.second, &_print_quickened);
+		} else if (res.first == "gc-stats") {
+			parseBoolArgument(res.first, res.second, &_gc_stats);
+		} else if (res.first == "gc-threshold") {
+			parseIntArgument(res.first, res.second, &_gc_threshold);
+		} else if (res.first == "jit") {
+			parseBoolArgument(res.first, res.second, &_jit);
+		} else if (res.first == "jit-threshold") {
+			parseIntArgument(res.first, res.second, &_jit_threshold);
+		} else if (res.first == "jit-perf-map") {
+			parseBoolArgument(res.first, res.second, &_jit_perf_map);
+		} else if (res.first == "time-report") {
+			parseBoolArgument(res.first, res.second, &_time_report);
+		} else if (res.first == "stats") {
+			parseBoolArgument(res.first, res.second, &_stats);
+		} else if (res.first == "fused-resolve") {
+			parseBoolArgument(res.first, res.second, &_fused_resolve);
+		} else if (res.first == "verify-resolve") {
+			parseBoolArgument(res.first, res.second, &_verify_resolve);
+		} else if (res.first == "trace-file") {
+			// The value is lower cased by splitArgKeyValue, but a path keeps its case.
+			trace_file(strchr(arg, '=') != NULL ? strchr(arg, '=') + 1 : "");
 		} else {
 			fprintf(stderr, "ringci: unknown argument: %s\n", res.first.c_str());
 		}
@@ -55,3 +91,28 @@ void Config::parseArgument(char* arg) {
 		source(arg);
 	}
 }
+
+
+bool Config::parseBoolArgument(const string& key, const string& val, bool* res) {
+	if (val == "" || val == "true") {
+		*res = true;
+	} else if (val == "false") {
+		*res = false;
+	} else {
+		fprintf(stderr, "ringci: %s should be one of: TRUE, FALSE\n", key.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+bool Config::parseIntArgument(const string& key, const string& val, int* res) {
+	char* end = NULL;
+	long num = strtol(val.c_str(), &end, 10);
+	if (val == "" || *end != '\0' || num < 0) {
+		fprintf(stderr, "ringci: %s should be a non-negative integer\n", key.c_str());
+		return false;
+	}
+	*res = num;
+	return true;
+}
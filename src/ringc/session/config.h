@@ -23,11 +23,28 @@ class Config {
 	ADD_PROPERTY(log_level, LogLevel)
 	ADD_PROPERTY(linker, string)
 	ADD_PROPERTY(link_opt, string)
+	ADD_PROPERTY(use_vm, bool)
+	ADD_PROPERTY(print_bytecode, bool)
+	ADD_PROPERTY(print_quickened, bool)
+	ADD_PROPERTY(gc_stats, bool)
+	ADD_PROPERTY(gc_threshold, int)
+	ADD_PROPERTY(jit, bool)
+	ADD_PROPERTY(jit_threshold, int)
+	ADD_PROPERTY(jit_perf_map, bool)
+	ADD_PROPERTY(time_report, bool)
+	ADD_PROPERTY(stats, bool)
+	ADD_PROPERTY(fused_resolve, bool)
+	ADD_PROPERTY(verify_resolve, bool)
+	ADD_PROPERTY_R(trace_file, string)
 
 public:
 	Config();
 
 	void parseArgument(char* arg);
+
+protected:
+	bool parseBoolArgument(const string& key, const string& val, bool* res);
+	bool parseIntArgument(const string& key, const string& val, int* res);
 };
 
 
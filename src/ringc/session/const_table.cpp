@@ -0,0 +1,138 @@
+#include "const_table.h"
+#include "session.h"
+#include "diagnostic.h"
+#include <cassert>
+#include <climits>
+using namespace ring::ringc;
+
+
+ConstTable::ConstTable(Session* session)
+		: _session(session)
+		, _true()
+		, _false() {
+}
+
+
+// Decodes a literal and returns the id of its constant.
+// An int literal must fit in `int`: a decimal one as a signed value, and a hexadecimal one as a
+// 32-bit pattern, so 0xffffffff is -1. A literal out of the range is an error.
+ConstId ConstTable::addLiteral(LiteralType lit_type, StrId str_id) {
+	switch (lit_type) {
+		case LIT_FALSE:
+			return addBool(false);
+		case LIT_TRUE:
+			return addBool(true);
+		case LIT_STRING:
+			return addString(str_id);
+		case LIT_NUM: {
+				int64_t value = 0;
+				if (!decodeInt(session()->str(str_id).str(), &value)) {
+					ERROR("Invalid integer literal: %s", session()->str(str_id).data());
+					return ConstId();
+				}
+				llvm::StringRef text = session()->str(str_id);
+				bool is_hex = text.startswith("0x") || text.startswith("0X");
+				if (value < 0 || value > (is_hex ? (int64_t)UINT_MAX : (int64_t)INT_MAX)) {
+					ERROR("Integer literal out of range of int: %s", text.data());
+					return ConstId();
+				}
+				return addInt(value, 32);
+			}
+		case LIT_CHAR:
+			break;
+	}
+	return ConstId();
+}
+
+
+ConstId ConstTable::addInt(int64_t value, int bits) {
+	pair<int64_t, int> key = make_pair(value, bits);
+	auto it = _int_map.find(key);
+	if (it != _int_map.end()) {
+		return it->second;
+	}
+	Constant constant = { CONST_INT, bits, value, StrId() };
+	return _int_map[key] = add(constant);
+}
+
+
+ConstId ConstTable::addBool(bool value) {
+	ConstId& const_id = value ? _true : _false;
+	if (const_id.none()) {
+		Constant constant = { CONST_BOOL, 1, value, StrId() };
+		const_id = add(constant);
+	}
+	return const_id;
+}
+
+
+ConstId ConstTable::addString(StrId str_id) {
+	auto it = _str_map.find(str_id);
+	if (it != _str_map.end()) {
+		return it->second;
+	}
+	Constant constant = { CONST_STRING, 0, 0, str_id };
+	return _str_map[str_id] = add(constant);
+}
+
+
+const Constant& ConstTable::value(ConstId const_id) const {
+	assert(const_id.value() >= 0 && const_id.value() < _consts.size());
+	return _consts[const_id.value()];
+}
+
+
+int64_t ConstTable::intValue(ConstId const_id) const {
+	return value(const_id).int_value;
+}
+
+
+int ConstTable::length() const {
+	return _consts.size();
+}
+
+
+// Decodes a decimal or `0x` prefixed hexadecimal integer literal.
+// Returns false if it is malformed or does not fit in 64 bits.
+bool ConstTable::decodeInt(const string& str, int64_t* res) {
+	uint64_t radix = 10;
+	size_t ix = 0;
+	if (str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+		radix = 16;
+		ix = 2;
+	}
+	if (ix == str.size()) {
+		return false;
+	}
+
+	uint64_t value = 0;
+	for (; ix < str.size(); ++ix) {
+		char ch = str[ix];
+		uint64_t digit = 0;
+		if (ch >= '0' && ch <= '9') {
+			digit = ch - '0';
+		} else if (radix == 16 && ch >= 'a' && ch <= 'f') {
+			digit = ch - 'a' + 10;
+		} else if (radix == 16 && ch >= 'A' && ch <= 'F') {
+			digit = ch - 'A' + 10;
+		} else {
+			return false;
+		}
+		if (value > (UINT64_MAX - digit) / radix) {
+			return false;
+		}
+		value = value * radix + digit;
+	}
+	// Decimal literals are signed, hexadecimal literals may use all 64 bits.
+	if (radix == 10 && value > INT64_MAX) {
+		return false;
+	}
+	*res = (int64_t)value;
+	return true;
+}
+
+
+ConstId ConstTable::add(const Constant& constant) {
+	_consts.push_back(constant);
+	return ConstId(_consts.size() - 1);
+}
@@ -0,0 +1,83 @@
+#ifndef RING_RINGC_SESSION_CONST_TABLE_H
+#define RING_RINGC_SESSION_CONST_TABLE_H
+
+
+namespace ring {
+namespace ringc {
+	class ConstTable;
+	class Session;
+}}
+
+
+#include "../../common.h"
+#include "../syntax/ast.h"
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+using namespace ring::ringc::ast;
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+enum ConstType {
+	CONST_INT,
+	CONST_BOOL,
+	CONST_STRING,
+};
+
+
+// A decoded literal.
+struct Constant {
+	ConstType type;
+	int bits;           // Width of an int constant.
+	int64_t int_value;  // Value of an int or bool constant.
+	StrId str_id;       // Value of a string constant.
+};
+
+
+// ConstTable holds literals decoded once when they are parsed, so that later phases read the
+// typed value instead of parsing the source text again.
+class ConstTable {
+	ADD_PROPERTY_P(session, Session)
+
+public:
+	ConstTable(Session* session);
+
+	// Decodes a literal and returns the id of its constant.
+	// Returns none if the literal has no constant value or is malformed.
+	ConstId addLiteral(LiteralType lit_type, StrId str_id);
+
+	ConstId addInt(int64_t value, int bits);
+	ConstId addBool(bool value);
+	ConstId addString(StrId str_id);
+
+	const Constant& value(ConstId const_id) const;
+	int64_t intValue(ConstId const_id) const;
+
+	int length() const;
+
+	// Decodes a decimal or `0x` prefixed hexadecimal integer literal.
+	// Returns false if it is malformed or does not fit in 64 bits.
+	static bool decodeInt(const string& str, int64_t* res);
+
+protected:
+	ConstId add(const Constant& constant);
+
+protected:
+	vector<Constant> _consts;
+	map<pair<int64_t, int>, ConstId> _int_map;
+	map<StrId, ConstId> _str_map;
+	ConstId _true;
+	ConstId _false;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
@@ -5,25 +5,36 @@ using namespace ring::ringc;
 Session::Session(Config* config)
 		: _config(config)
 		, _str_table(new StrTable(""))
+		, _source_map(new SourceMap())
+		, _ast_arena(new Arena())
 		, _ast_table(new AstTable(this))
+		, _flat_ast(new FlatAst())
 		, _type_table(new TypeTable(this))
+		, _const_table(new ConstTable(this))
 		, _scope_table(new ScopeTable(NULL))
-		, _symbol_table(new SymbolTable(NULL))
+		, _symbol_table(new SymbolTable())
 		, _scope_node_map(new ScopeNodeMap(ScopeId(), NodeId()))
 		, _diagnostic(new Diagnostic(config->log_level()))
 		, _ast_fac(new AstFactory(this))
 		, _ast_str(new AstStringify(this))
+		, _stats(new Stats(this))
 		, _main() {
 }
 
 
 Session::~Session() {
+	delete _stats;
 	delete _ast_str;
 	delete _ast_fac;
 	delete _diagnostic;
 	delete _scope_node_map;
+	delete _symbol_table;
 	delete _scope_table;
+	delete _const_table;
+	delete _flat_ast;
 	delete _ast_table;
+	delete _ast_arena;
+	delete _source_map;
 	delete _str_table;
 }
 
@@ -38,6 +49,6 @@ bool Session::setMain(NodeId main) {
 }
 
 
-const string& Session::str(StrId str) const {
+llvm::StringRef Session::str(StrId str) const {
 	return _str_table->value(str);
 }
\ No newline at end of file
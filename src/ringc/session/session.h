@@ -9,16 +9,22 @@ namespace ringc {
 
 
 #include "../../common.h"
+#include "str_table.h"
+#include "source_map.h"
 #include "ast_table.h"
 #include "type_table.h"
+#include "const_table.h"
 #include "diagnostic.h"
 #include "config.h"
-#include "../util/table_map.h"
-#include "../util/bi_map.h"
+#include "stats.h"
+#include "../util/id_table.h"
+#include "../util/arena.h"
+#include "../util/dense_bi_map.h"
 #include "../front/symbol.h"
 #include "../front/scope.h"
 #include "../syntax/ast.h"
 #include "../syntax/ast_factory.h"
+#include "../syntax/flat_ast.h"
 #include "../syntax/ast_stringify.h"
 using namespace ring::ringc::ast;
 
@@ -26,10 +32,8 @@ using namespace ring::ringc::ast;
 namespace ring {
 namespace ringc {
 
-typedef TableMap<StrId, string> StrTable;
-typedef TableMap<ScopeId, Scope*> ScopeTable;
-typedef TableMap<SymbolId, Symbol*> SymbolTable;
-typedef BiMap<ScopeId, NodeId> ScopeNodeMap;
+typedef IdTable<ScopeId, Scope*> ScopeTable;
+typedef DenseBiMap<ScopeId, NodeId> ScopeNodeMap;
 
 class Session {
 public:
@@ -38,19 +42,24 @@ public:
 
 	ADD_PROPERTY_P(config, Config)
 	ADD_PROPERTY_P(str_table, StrTable)
+	ADD_PROPERTY_P(source_map, SourceMap) // Owns the sources, and finds lines of offsets.
+	ADD_PROPERTY_P(ast_arena, Arena) // Owns the AST nodes and their child arrays.
 	ADD_PROPERTY_P(ast_table, AstTable)
+	ADD_PROPERTY_P(flat_ast, FlatAst) // Flat encoding of the module, with -fused-resolve=false.
 	ADD_PROPERTY_P(type_table, TypeTable)
+	ADD_PROPERTY_P(const_table, ConstTable)
 	ADD_PROPERTY_P(scope_table, ScopeTable)
 	ADD_PROPERTY_P(symbol_table, SymbolTable)
 	ADD_PROPERTY_P(scope_node_map, ScopeNodeMap)
 	ADD_PROPERTY_P(diagnostic, Diagnostic)
 	ADD_PROPERTY_P(ast_fac, AstFactory)
 	ADD_PROPERTY_P(ast_str, AstStringify)
+	ADD_PROPERTY_P(stats, Stats)
 	ADD_PROPERTY(main, NodeId);
 
 public:
 	bool setMain(NodeId main);
-	const string& str(StrId str_id) const;
+	llvm::StringRef str(StrId str_id) const;
 };
 
 
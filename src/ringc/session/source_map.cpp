@@ -0,0 +1,80 @@
+#include "source_map.h"
+#include "../front/scan.h"
+#include <algorithm>
+#include <cstdio>
+using namespace ring::ringc;
+using namespace std;
+
+
+SourceMap::SourceMap()
+		: _end(0) {
+}
+
+
+SourceMap::~SourceMap() {
+	for_each(_sources.begin(), _sources.end(), [](Source& source) {
+		delete source.reader;
+	});
+}
+
+
+// A gap of one is left after each source so its end offset, where EoF is, is still in it.
+uint32_t SourceMap::add(Reader* reader) {
+	Source source;
+	source.reader = reader;
+	source.base = _end;
+	source.has_lines = false;
+	_sources.push_back(source);
+	_end += reader->length() + 1;
+	return source.base;
+}
+
+
+bool SourceMap::lineCol(uint32_t offset, int* line, int* col) {
+	Source* found = find(offset);
+	if (!found) {
+		return false;
+	}
+	Source& source = *found;
+	if (!source.has_lines) {
+		llvm::StringRef src = source.reader->slice(0, source.reader->length());
+		ScanUtil::lineStarts(src.data(), src.size(), &source.line_starts);
+		source.has_lines = true;
+	}
+	uint32_t local = offset - source.base;
+	auto line_it = upper_bound(source.line_starts.begin(), source.line_starts.end(), local);
+	uint32_t line_start = line_it == source.line_starts.begin() ? 0 : *(line_it - 1);
+	*line = (line_it - source.line_starts.begin()) + 1;
+	*col = local - line_start + 1;
+	return true;
+}
+
+
+string SourceMap::location(uint32_t offset) {
+	int line, col;
+	if (!lineCol(offset, &line, &col)) {
+		return "?";
+	}
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%d:%d", line, col);
+	return buffer;
+}
+
+
+llvm::StringRef SourceMap::text(uint32_t offset) {
+	Source* source = find(offset);
+	if (!source) {
+		return llvm::StringRef();
+	}
+	return source->reader->slice(0, source->reader->length());
+}
+
+
+SourceMap::Source* SourceMap::find(uint32_t offset) {
+	auto it = upper_bound(_sources.begin(), _sources.end(), offset,
+			[](uint32_t offset, const Source& source) { return offset < source.base; });
+	if (it == _sources.begin() || offset >= _end) {
+		return NULL;
+	}
+	return &*(it - 1);
+}
@@ -0,0 +1,68 @@
+#ifndef RING_RINGC_SESSION_SOURCE_MAP_H
+#define RING_RINGC_SESSION_SOURCE_MAP_H
+
+
+namespace ring {
+namespace ringc {
+	class SourceMap;
+}}
+
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../front/reader.h"
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// SourceMap keeps the sources of a session, and turns source offsets into lines and columns.
+// All the sources share one offset space: each is given a base offset past the end of the
+// previous one, so a 32-bit offset on a token or an AST node tells both the source and the
+// position in it. Nothing is tracked per line while lexing; the line starts of a source are found
+// by a scan of it the first time one of its offsets needs a line.
+class SourceMap {
+public:
+	SourceMap();
+	~SourceMap();
+
+	SourceMap(const SourceMap&) = delete;
+	SourceMap& operator =(const SourceMap&) = delete;
+
+	// Takes the ownership of `reader`, and returns the base offset of its source.
+	uint32_t add(Reader* reader);
+
+	// Finds the 1-based line and column of an offset. Returns false if it is in no source.
+	bool lineCol(uint32_t offset, int* line, int* col);
+
+	// Returns "line:col" of an offset, or "?" if it is in no source.
+	string location(uint32_t offset);
+
+	// Returns the whole text of the source an offset is in, or an empty one if it is in no source.
+	llvm::StringRef text(uint32_t offset);
+
+protected:
+	struct Source {
+		Reader* reader;
+		uint32_t base;
+		bool has_lines;
+		vector<uint32_t> line_starts; // Offsets in the source of the lines after the first.
+	};
+
+	// Returns the source an offset is in, or NULL.
+	Source* find(uint32_t offset);
+
+protected:
+	vector<Source> _sources;
+	uint32_t _end;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
@@ -0,0 +1,178 @@
+#include "stats.h"
+#include "session.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <unistd.h>
+using namespace ring::ringc;
+using namespace std;
+
+
+Stats::Stats(Session* session)
+		: _session(session)
+		, _enabled(session->config()->time_report() || session->config()->trace_file() != "")
+		, _depth(0)
+		, _start(chrono::steady_clock::now()) {
+}
+
+
+int Stats::beginPhase(const string& name) {
+	Phase phase;
+	phase.name = name;
+	phase.depth = _depth++;
+	phase.start_us = elapsedUs();
+	phase.cpu_us = cpuUs();
+	phase.allocs = numAllocs();
+	phase.alloc_bytes = allocBytes();
+	phase.wall_us = 0;
+	_phases.push_back(phase);
+	return _phases.size() - 1;
+}
+
+
+// Turns the values taken at the beginning into the differences.
+void Stats::endPhase(int ix) {
+	Phase& phase = _phases[ix];
+	phase.wall_us = elapsedUs() - phase.start_us;
+	phase.cpu_us = cpuUs() - phase.cpu_us;
+	phase.allocs = numAllocs() - phase.allocs;
+	phase.alloc_bytes = allocBytes() - phase.alloc_bytes;
+	_depth--;
+}
+
+
+void Stats::report(FILE* fd) {
+	if (session()->config()->time_report()) {
+		printTimeReport(fd);
+	}
+	if (session()->config()->stats()) {
+		printTableSizes(fd);
+	}
+	if (session()->config()->trace_file() != "") {
+		writeTrace(session()->config()->trace_file());
+	}
+}
+
+
+// Phases of the same name are summed up, in the order they first began.
+void Stats::printTimeReport(FILE* fd) {
+	vector<Phase> sums;
+	vector<int> counts;
+	map<string, int> index;
+	for_each(_phases.begin(), _phases.end(), [&sums, &counts, &index](const Phase& phase) {
+		auto it = index.find(phase.name);
+		if (it == index.end()) {
+			index[phase.name] = sums.size();
+			sums.push_back(phase);
+			counts.push_back(1);
+			return;
+		}
+		Phase& sum = sums[it->second];
+		sum.wall_us += phase.wall_us;
+		sum.cpu_us += phase.cpu_us;
+		sum.allocs += phase.allocs;
+		sum.alloc_bytes += phase.alloc_bytes;
+		sum.depth = min(sum.depth, phase.depth);
+		counts[it->second]++;
+	});
+
+	fprintf(fd, "===== time report =====\n");
+	fprintf(fd, "%-32s %6s %12s %12s %10s %12s\n",
+			"phase", "count", "wall ms", "cpu ms", "allocs", "alloc bytes");
+	for (int i = 0; i < sums.size(); ++i) {
+		const Phase& sum = sums[i];
+		string name = string(sum.depth * 2, ' ') + sum.name;
+		fprintf(fd, "%-32s %6d %12.3f %12.3f %10lld %12lld\n",
+				name.c_str(), counts[i], sum.wall_us / 1000, sum.cpu_us / 1000,
+				(long long)sum.allocs, (long long)sum.alloc_bytes);
+	}
+	fprintf(fd, "%-32s %6s %12.3f %12.3f %10lld %12lld\n",
+			"total", "", elapsedUs() / 1000, cpuUs() / 1000,
+			(long long)numAllocs(), (long long)allocBytes());
+}
+
+
+void Stats::printTableSizes(FILE* fd) {
+	fprintf(fd, "===== stats =====\n");
+	fprintf(fd, "%-16s %10d %10zu bytes\n", "str_table", session()->str_table()->length(),
+			session()->str_table()->memoryUsage());
+	fprintf(fd, "%-16s %10d %10zu bytes\n", "ast_table", session()->ast_table()->length(),
+			session()->ast_arena()->memoryUsage());
+	if (session()->flat_ast()->length() > 0) {
+		fprintf(fd, "%-16s %10d %10zu bytes\n", "flat_ast", (int)session()->flat_ast()->length(),
+				session()->flat_ast()->memoryUsage());
+	}
+	fprintf(fd, "%-16s %10d %10zu bytes\n", "symbol_table", session()->symbol_table()->length(),
+			session()->symbol_table()->memoryUsage());
+	fprintf(fd, "%-16s %10d %10zu bytes\n", "scope_table", session()->scope_table()->length(),
+			session()->scope_table()->memoryUsage());
+	fprintf(fd, "%-16s %10d %10zu bytes\n", "type_table", session()->type_table()->length(),
+			session()->type_table()->memoryUsage());
+	fprintf(fd, "%-16s %10d\n", "const_table", session()->const_table()->length());
+}
+
+
+// Writes the phases as complete events of the Chrome trace event format, which chrome://tracing
+// and Perfetto load.
+bool Stats::writeTrace(const string& path) {
+	FILE* fd = fopen(path.c_str(), "w");
+	if (fd == NULL) {
+		fprintf(stderr, "Could not open trace file: %s\n", path.c_str());
+		return false;
+	}
+	int pid = getpid();
+	fprintf(fd, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (int i = 0; i < _phases.size(); ++i) {
+		const Phase& phase = _phases[i];
+		fprintf(fd, "  {\"name\": \"%s\", \"cat\": \"ring\", \"ph\": \"X\", \"ts\": %.3f, "
+				"\"dur\": %.3f, \"pid\": %d, \"tid\": 0, \"args\": {\"cpu_ms\": %.3f, "
+				"\"allocs\": %lld, \"alloc_bytes\": %lld}}%s\n",
+				phase.name.c_str(), phase.start_us, phase.wall_us, pid, phase.cpu_us / 1000,
+				(long long)phase.allocs, (long long)phase.alloc_bytes,
+				i + 1 < _phases.size() ? "," : "");
+	}
+	fprintf(fd, "]}\n");
+	fclose(fd);
+	return true;
+}
+
+
+// The AST and type nodes come from arenas, and the strings from the string table, so these are
+// counted where they are made rather than by hooking the global allocator.
+int64_t Stats::numAllocs() const {
+	return _session->ast_arena()->numAllocs() + _session->type_table()->arena().numAllocs() +
+		_session->str_table()->length();
+}
+
+
+int64_t Stats::allocBytes() const {
+	return _session->ast_arena()->allocBytes() + _session->type_table()->arena().allocBytes() +
+		_session->str_table()->memoryUsage();
+}
+
+
+double Stats::elapsedUs() const {
+	return chrono::duration<double, micro>(chrono::steady_clock::now() - _start).count();
+}
+
+
+double Stats::cpuUs() {
+	return (double)clock() * 1000000 / CLOCKS_PER_SEC;
+}
+
+
+PhaseTimer::PhaseTimer(Session* session, const string& name)
+		: _stats(session->stats())
+		, _phase(-1) {
+	if (_stats->enabled()) {
+		_phase = _stats->beginPhase(name);
+	}
+}
+
+
+PhaseTimer::~PhaseTimer() {
+	if (_phase >= 0) {
+		_stats->endPhase(_phase);
+	}
+}
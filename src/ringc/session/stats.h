@@ -0,0 +1,92 @@
+#ifndef RING_RINGC_SESSION_STATS_H
+#define RING_RINGC_SESSION_STATS_H
+
+
+namespace ring {
+namespace ringc {
+	class Session;
+	class Stats;
+	class PhaseTimer;
+}}
+
+
+#include "../../common.h"
+#include <chrono>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// Stats records the phases of a session for `-time-report` and `-trace-file`, and reports the
+// sizes of the session tables for `-stats`.
+// Phases are recorded only when one of the reports is asked, so a PhaseTimer costs nothing
+// otherwise.
+class Stats {
+	ADD_PROPERTY_P(session, Session)
+
+public:
+	struct Phase {
+		string name;
+		int depth;          // Number of enclosing phases.
+		double start_us;    // Since the session started.
+		double wall_us;
+		double cpu_us;
+		int64_t allocs;     // Allocations of the session made during the phase.
+		int64_t alloc_bytes;
+	};
+
+	Stats(Session* session);
+
+	bool enabled() const { return _enabled; }
+
+	// Starts a phase and returns its index.
+	int beginPhase(const string& name);
+	void endPhase(int phase);
+
+	// Prints the reports asked by the config, and writes the trace file.
+	void report(FILE* fd);
+
+	void printTimeReport(FILE* fd);
+	void printTableSizes(FILE* fd);
+	bool writeTrace(const string& path);
+
+	// Counts of the allocations of the session so far: the nodes in the AST and type arenas,
+	// and the strings in the string table.
+	int64_t numAllocs() const;
+	int64_t allocBytes() const;
+
+protected:
+	double elapsedUs() const;
+	static double cpuUs();
+
+protected:
+	bool _enabled;
+	int _depth;
+	chrono::steady_clock::time_point _start;
+	vector<Phase> _phases;
+};
+
+
+// Records a phase for the lifetime of the timer.
+class PhaseTimer {
+public:
+	PhaseTimer(Session* session, const string& name);
+	~PhaseTimer();
+
+private:
+	Stats* _stats;
+	int _phase;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
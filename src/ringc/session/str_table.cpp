@@ -0,0 +1,138 @@
+#include "str_table.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+using namespace ring::ringc;
+using namespace std;
+
+
+#define STR_ARENA_SIZE (64 * 1024)
+#define STR_INIT_SLOTS 1024
+
+
+StrTable::StrTable(llvm::StringRef first)
+		: _slots(STR_INIT_SLOTS, -1)
+		, _top(NULL)
+		, _end(NULL)
+		, _arena_bytes(0) {
+	add(first);
+}
+
+
+StrTable::~StrTable() {
+	for_each(_arenas.begin(), _arenas.end(), [](char* arena) {
+		free(arena);
+	});
+}
+
+
+int StrTable::length() const {
+	return _entries.size();
+}
+
+
+StrId StrTable::add(llvm::StringRef str) {
+	uint32_t h = hash(str);
+	size_t slot = findSlot(str, h);
+	if (_slots[slot] >= 0) {
+		return StrId(_slots[slot]);
+	}
+
+	Entry entry = { store(str), (uint32_t)str.size(), h };
+	_entries.push_back(entry);
+	_slots[slot] = _entries.size() - 1;
+
+	// Keeps the load factor at most a half, so probe sequences stay short.
+	if (_entries.size() * 2 > _slots.size()) {
+		grow();
+	}
+	return StrId(_entries.size() - 1);
+}
+
+
+bool StrTable::contains(llvm::StringRef str) const {
+	return id(str).some();
+}
+
+
+StrId StrTable::id(llvm::StringRef str) const {
+	int32_t ix = _slots[findSlot(str, hash(str))];
+	return ix >= 0 ? StrId(ix) : StrId();
+}
+
+
+llvm::StringRef StrTable::value(StrId id) const {
+	const Entry& entry = id.value() < 0 || id.value() >= length() ?
+		_entries[0] : _entries[id.value()];
+	return llvm::StringRef(entry.chars, entry.len);
+}
+
+
+size_t StrTable::memoryUsage() const {
+	return _arena_bytes + _entries.capacity() * sizeof(Entry) + _slots.capacity() * sizeof(int32_t);
+}
+
+
+// FNV-1a.
+uint32_t StrTable::hash(llvm::StringRef str) {
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < str.size(); ++i) {
+		h = (h ^ (unsigned char)str[i]) * 16777619u;
+	}
+	return h;
+}
+
+
+size_t StrTable::findSlot(llvm::StringRef str, uint32_t hash) const {
+	size_t mask = _slots.size() - 1;
+	for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+		int32_t ix = _slots[slot];
+		if (ix < 0) {
+			return slot;
+		}
+		const Entry& entry = _entries[ix];
+		if (entry.hash == hash && entry.len == str.size() &&
+				memcmp(entry.chars, str.data(), str.size()) == 0) {
+			return slot;
+		}
+	}
+}
+
+
+// Doubles the index. The hashes are kept in the entries, so the strings are not hashed again.
+void StrTable::grow() {
+	vector<int32_t> slots(_slots.size() * 2, -1);
+	size_t mask = slots.size() - 1;
+	for (int32_t ix = 0; ix < (int32_t)_entries.size(); ++ix) {
+		size_t slot = _entries[ix].hash & mask;
+		while (slots[slot] >= 0) {
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = ix;
+	}
+	_slots.swap(slots);
+}
+
+
+// A string longer than an arena gets an arena of its own.
+const char* StrTable::store(llvm::StringRef str) {
+	size_t size = str.size() + 1;
+	if (_top == NULL || _top + size > _end) {
+		size_t arena_size = max<size_t>(STR_ARENA_SIZE, size);
+		char* arena = reinterpret_cast<char*>(malloc(arena_size));
+		if (arena == NULL) {
+			fprintf(stderr, "Out of memory: string table\n");
+			exit(EXIT_FAILURE);
+		}
+		_arenas.push_back(arena);
+		_arena_bytes += arena_size;
+		_top = arena;
+		_end = arena + arena_size;
+	}
+	char* res = _top;
+	memcpy(res, str.data(), str.size());
+	res[str.size()] = '\0';
+	_top += size;
+	return res;
+}
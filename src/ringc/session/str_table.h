@@ -0,0 +1,81 @@
+#ifndef RING_RINGC_SESSION_STR_TABLE_H
+#define RING_RINGC_SESSION_STR_TABLE_H
+
+
+namespace ring {
+namespace ringc {
+	class StrTable;
+}}
+
+
+#include "../../common.h"
+#include <stdint.h>
+#include <vector>
+#include "llvm/ADT/StringRef.h"
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// StrTable interns strings: equal strings get the same id.
+// The chars of each string are stored once in append-only arenas and never move, so the value of
+// an id is a stable slice. Every value is followed by a NUL, so its data() is also a C string.
+// Ids are looked up by an open addressing hash index, probed linearly.
+class StrTable {
+public:
+	// `first` becomes the string of id 0, which is also the value of an unknown id.
+	StrTable(llvm::StringRef first);
+	~StrTable();
+
+	// Returns the number of strings.
+	int length() const;
+
+	// Adds a string and returns its id.
+	// If the string already exists, returns the id.
+	StrId add(llvm::StringRef str);
+
+	// Returns true if the table contains the string.
+	bool contains(llvm::StringRef str) const;
+
+	// Returns id for the string, none if there is not the string.
+	StrId id(llvm::StringRef str) const;
+
+	// Returns string for the id, or the first string if there is no such id.
+	llvm::StringRef value(StrId id) const;
+
+	// Returns the bytes of the arenas and of the index.
+	size_t memoryUsage() const;
+
+protected:
+	struct Entry {
+		const char* chars;
+		uint32_t len;
+		uint32_t hash;
+	};
+
+	static uint32_t hash(llvm::StringRef str);
+
+	// Returns the slot of the string, which is empty if the table does not contain it.
+	size_t findSlot(llvm::StringRef str, uint32_t hash) const;
+	void grow();
+
+	// Copies the string into the arena, followed by a NUL.
+	const char* store(llvm::StringRef str);
+
+protected:
+	vector<Entry> _entries;
+	vector<int32_t> _slots; // Index of the entry, or -1 for an empty slot.
+	vector<char*> _arenas;
+	char* _top;
+	char* _end;
+	size_t _arena_bytes;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
@@ -1,17 +1,25 @@
 #include "type_table.h"
-#include <algorithm>
 using namespace std;
 using namespace ring::ringc;
 
 
 TypeTable::TypeTable(Session* session)
 		: _session(session)
-		, _type_table(NULL) {
+		, _type_table(NULL)
+		, _hashes(1, 0)
+		, _func_slots(16)
+		, _num_func_types(0) {
 }
 
 
+// The type nodes live in the arena; only the argument vectors of the function types need to be
+// destroyed.
 TypeTable::~TypeTable() {
-	for_each(_type_table.begin(), _type_table.end(), [](Type* type) { delete type; });
+	for (auto it = _type_table.begin(); it != _type_table.end(); ++it) {
+		if (*it != NULL && (*it)->isFunctionType()) {
+			static_cast<FunctionType*>(*it)->~FunctionType();
+		}
+	}
 }
 
 
@@ -34,24 +42,32 @@ FunctionType* TypeTable::getFuncType(TypeId type_id) {
 
 
 TypeId TypeTable::getPrimTypeId(const PrimTypeKey& prim_type_key) {
-	if (_prim_type_map.count(prim_type_key) > 0) {
-		return _prim_type_map[prim_type_key];
-	} else {
-		TypeId type_id = addType(new PrimitiveType(prim_type_key));
-		_prim_type_map[prim_type_key] = type_id;
-		return type_id;
+	ASSERT(prim_type_key >= 0 && prim_type_key <= PRIM_TYPE_BOOL, SRCPOS);
+	TypeId& type_id = _prim_type_ids[prim_type_key];
+	if (type_id.none()) {
+		type_id = addType(_arena.create<PrimitiveType>(prim_type_key), prim_type_key);
 	}
+	return type_id;
 }
 
 
 TypeId TypeTable::getFuncTypeId(const FuncTypeKey& func_type_key) {
-	if (_func_type_map.count(func_type_key) > 0) {
-		return _func_type_map[func_type_key];
-	} else {
-		TypeId type_id = addType(new FunctionType(func_type_key.first, func_type_key.second));
-		_func_type_map[func_type_key] = type_id;
-		return type_id;
+	const vector<TypeId>& args = func_type_key.first;
+	TypeId ret = func_type_key.second;
+	uint32_t hash = hashFuncType(args, ret);
+	size_t slot = findFuncSlot(args, ret, hash);
+	if (_func_slots[slot].some()) {
+		return _func_slots[slot];
+	}
+	// Keeps the load factor at most a half.
+	if ((_num_func_types + 1) * 2 > (int)_func_slots.size()) {
+		growFuncSlots();
+		slot = findFuncSlot(args, ret, hash);
 	}
+	TypeId type_id = addType(_arena.create<FunctionType>(args, ret), hash);
+	_func_slots[slot] = type_id;
+	++_num_func_types;
+	return type_id;
 }
 
 
@@ -65,6 +81,17 @@ bool TypeTable::isPrimType(TypeId type_id) {
 }
 
 
+int TypeTable::length() const {
+	return _type_table.length();
+}
+
+
+size_t TypeTable::memoryUsage() const {
+	return _arena.memoryUsage() + _type_table.memoryUsage() +
+		_hashes.capacity() * sizeof(uint32_t) + _func_slots.capacity() * sizeof(TypeId);
+}
+
+
 bool TypeTable::isFuncType(TypeId type_id) {
 	if (type_id.none()) {
 		return false;
@@ -75,10 +102,56 @@ bool TypeTable::isFuncType(TypeId type_id) {
 }
 
 
-TypeId TypeTable::addType(Type* type) {
+TypeId TypeTable::addType(Type* type, uint32_t hash) {
 	ASSERT(type->type_id().none(), SRCPOS);
 	TypeId type_id = _type_table.add(type);
 	type->type_id(type_id);
+	_hashes.push_back(hash);
 	return type_id;
 }
 
+
+// FNV-1a over the ids of the return type and the argument types.
+uint32_t TypeTable::hashFuncType(const vector<TypeId>& args, TypeId ret) {
+	uint32_t hash = 2166136261u;
+	hash = (hash ^ (uint32_t)ret.value()) * 16777619u;
+	for (size_t i = 0; i < args.size(); ++i) {
+		hash = (hash ^ (uint32_t)args[i].value()) * 16777619u;
+	}
+	return (hash ^ (uint32_t)args.size()) * 16777619u;
+}
+
+
+// Linear probing; the stored hash is compared before the types themselves.
+size_t TypeTable::findFuncSlot(const vector<TypeId>& args, TypeId ret, uint32_t hash) const {
+	size_t mask = _func_slots.size() - 1;
+	size_t slot = hash & mask;
+	while (_func_slots[slot].some()) {
+		TypeId type_id = _func_slots[slot];
+		if (_hashes[type_id.value()] == hash) {
+			FunctionType* type = static_cast<FunctionType*>(_type_table.value(type_id));
+			if (type->ret() == ret && type->args() == args) {
+				break;
+			}
+		}
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+
+void TypeTable::growFuncSlots() {
+	vector<TypeId> slots;
+	slots.swap(_func_slots);
+	_func_slots.resize(slots.size() * 2);
+	size_t mask = _func_slots.size() - 1;
+	for (size_t i = 0; i < slots.size(); ++i) {
+		if (slots[i].some()) {
+			size_t slot = _hashes[slots[i].value()] & mask;
+			while (_func_slots[slot].some()) {
+				slot = (slot + 1) & mask;
+			}
+			_func_slots[slot] = slots[i];
+		}
+	}
+}
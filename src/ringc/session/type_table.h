@@ -3,7 +3,9 @@
 
 
 #include "../../common.h"
-#include "../util/table_map.h"
+#include <stdint.h>
+#include "../util/arena.h"
+#include "../util/id_table.h"
 #include "../syntax/ast.h"
 using namespace ring::ringc::ast;
 
@@ -22,6 +24,10 @@ namespace ring {
 namespace ringc {
 
 
+// TypeTable interns types: structurally equal types get the same id, so types are compared by id.
+// The primitive types are cached by kind, and function types are hash-consed in an open addressing
+// table keyed by the structural hash of the type, which is computed once when it is added. The
+// type nodes live in an arena owned by the table.
 class TypeTable {
 	ADD_PROPERTY_P(session, Session);
 public:
@@ -37,13 +43,30 @@ public:
 	bool isFuncType(TypeId type_id);
 	bool isPrimType(TypeId type_id);
 
+	int length() const;
+
+	// Returns the bytes of the type nodes and the tables.
+	size_t memoryUsage() const;
+
+	// Returns the arena of the type nodes.
+	const Arena& arena() const { return _arena; }
+
 protected:
-	TypeId addType(Type* type);
+	TypeId addType(Type* type, uint32_t hash);
+
+	static uint32_t hashFuncType(const vector<TypeId>& args, TypeId ret);
+
+	// Returns the slot of the function type, which is empty if it is not interned yet.
+	size_t findFuncSlot(const vector<TypeId>& args, TypeId ret, uint32_t hash) const;
+	void growFuncSlots();
 
 protected:
-	TableMap<TypeId, Type*> _type_table;
-	map<PrimTypeKey, TypeId> _prim_type_map;
-	map<FuncTypeKey, TypeId> _func_type_map;
+	Arena _arena;
+	IdTable<TypeId, Type*> _type_table;
+	vector<uint32_t> _hashes; // Structural hash of each type, indexed by type id.
+	TypeId _prim_type_ids[PRIM_TYPE_BOOL + 1];
+	vector<TypeId> _func_slots;
+	int _num_func_types;
 };
 
 
@@ -177,7 +177,8 @@ bool Property::isIdent() const {
 AstNode::AstNode(AstNodeType node_type)
 		: _parent(NULL)
 		, _node_id()
-		, _node_type(node_type) {
+		, _node_type(node_type)
+		, _offset(0) {
 }
 
 
@@ -191,6 +192,11 @@ bool AstNode::isUse() const {
 }
 
 
+bool AstNode::isExtern() const {
+	return _node_type == AST_EXTERN;
+}
+
+
 bool AstNode::isStmt() const {
 	return isLet() || isExpr();
 }
@@ -211,8 +217,12 @@ bool AstNode::isExprFn() const {
 }
 
 
-Module::Module()
-	: AstNode(AST_MODULE) {
+Module::Module(Arena* arena)
+	: AstNode(AST_MODULE)
+	, _uses(arena)
+	, _exts(arena)
+	, _decls(arena)
+	, _frame_size(0) {
 }
 
 
@@ -277,8 +287,9 @@ ExprEmpty::ExprEmpty()
 }
 
 
-ExprBlock::ExprBlock()
-		: Expr(AST_EXPR_BLOCK) {
+ExprBlock::ExprBlock(Arena* arena)
+		: Expr(AST_EXPR_BLOCK)
+		, _stmts(arena) {
 }
 
 
@@ -287,10 +298,11 @@ void ExprBlock::addStatement(Stmt* stmt) {
 }
 
 
-ExprFn::ExprFn(TypeId type_id, const vector<Ident>& args, ExprBlock* body)
+ExprFn::ExprFn(Arena* arena, TypeId type_id, const vector<Ident>& args, ExprBlock* body)
 		: Expr(AST_EXPR_FN)
-		, _args(args)
-		, _body(body) {
+		, _args(arena, args)
+		, _body(body)
+		, _frame_size(0) {
 	Expr::type_id(type_id);
 }
 
@@ -312,7 +324,8 @@ ExprIdent::ExprIdent(Ident id)
 ExprLiteral::ExprLiteral(LiteralType lit_type, StrId str_id)
 		: Expr(AST_EXPR_LITERAL)
 		, _lit_type(lit_type)
-		, _str_id(str_id) {
+		, _str_id(str_id)
+		, _const_id() {
 }
 
 
@@ -323,10 +336,11 @@ ExprMember::ExprMember(Expr* object, Property property)
 }
 
 
-ExprCall::ExprCall(Expr* callee, const vector<Expr*>& args)
+ExprCall::ExprCall(Arena* arena, Expr* callee, const vector<Expr*>& args)
 		: Expr(AST_EXPR_CALL)
 		, _callee(callee)
-		, _args(args) {
+		, _args(arena, args)
+		, _tail(false) {
 }
 
 
@@ -2,10 +2,12 @@
 #define RING_RINGC_SYNTAX_AST_H
 
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include "../../common.h"
 #include "token.h"
+#include "../util/arena.h"
 using namespace std;
 
 
@@ -211,6 +213,7 @@ class AstNode {
 	ADD_PROPERTY_P(parent, AstNode)
 	ADD_PROPERTY(node_id, NodeId)
 	ADD_PROPERTY(node_type, AstNodeType)
+	ADD_PROPERTY(offset, uint32_t) // Source offset of the node; see SourceMap.
 
 public:
 	bool isModule() const;
@@ -229,9 +232,10 @@ protected:
 // AST node for module.
 // A module consists of child modules and declarations.
 class Module : public AstNode {
-	ADD_PROPERTY_R(uses, vector<Use*>)
-	ADD_PROPERTY_R(exts, vector<Extern*>)
-	ADD_PROPERTY_R(decls, vector<Let*>)
+	ADD_PROPERTY_R(uses, ArenaArray<Use*>)
+	ADD_PROPERTY_R(exts, ArenaArray<Extern*>)
+	ADD_PROPERTY_R(decls, ArenaArray<Let*>)
+	ADD_PROPERTY(frame_size, int) // Number of slots for module level symbols.
 	friend class AstFactory;
 
 public:
@@ -240,7 +244,7 @@ public:
 	void addDecl(Let* decl);
 
 protected:
-	Module();
+	Module(Arena* arena);
 };
 
 
@@ -317,14 +321,14 @@ protected:
 
 // AST node for block expression.
 class ExprBlock : public Expr {
-	ADD_PROPERTY_R(stmts, vector<Stmt*>)
+	ADD_PROPERTY_R(stmts, ArenaArray<Stmt*>)
 	friend class AstFactory;
 
 public:
 	void addStatement(Stmt* stmt);
 
 protected:
-	ExprBlock();
+	ExprBlock(Arena* arena);
 };
 
 
@@ -333,12 +337,13 @@ protected:
 //   argument_list = empty | ( ident ':' type | ident ':' type ',' argument_list ) ;
 //   return_type = type ;
 class ExprFn : public Expr {
-	ADD_PROPERTY_R(args, vector<Ident>)
+	ADD_PROPERTY_R(args, ArenaArray<Ident>)
 	ADD_PROPERTY_P(body, ExprBlock)
+	ADD_PROPERTY(frame_size, int) // Number of slots for the arguments and locals.
 	friend class AstFactory;
 
 protected:
-	ExprFn(TypeId type_id, const vector<Ident>& args, ExprBlock* body);
+	ExprFn(Arena* arena, TypeId type_id, const vector<Ident>& args, ExprBlock* body);
 };
 
 
@@ -368,6 +373,7 @@ protected:
 class ExprLiteral : public Expr {
 	ADD_PROPERTY(lit_type, LiteralType)
 	ADD_PROPERTY(str_id, StrId)
+	ADD_PROPERTY(const_id, ConstId) // Decoded value in the constant table.
 	friend class AstFactory;
 
 protected:
@@ -397,11 +403,12 @@ protected:
 //   arguments = '(' ')' | '(' argument_list ')' ;
 class ExprCall : public Expr {
 	ADD_PROPERTY_P(callee, Expr)
-	ADD_PROPERTY_R(args, vector<Expr*>)
+	ADD_PROPERTY_R(args, ArenaArray<Expr*>)
+	ADD_PROPERTY(tail, bool) // The result of the call is the result of the enclosing function.
 	friend class AstFactory;
 
 protected:
-	ExprCall(Expr* callee, const vector<Expr*>& args);
+	ExprCall(Arena* arena, Expr* callee, const vector<Expr*>& args);
 };
 
 
@@ -14,89 +14,97 @@ AstNode* AstFactory::assignNode(AstNode* node) {
 }
 
 
+Arena* AstFactory::arena() {
+	return _session->ast_arena();
+}
+
+
 Module* AstFactory::createModule() {
-	return static_cast<Module*>(assignNode(new Module()));
+	return create<Module>(arena());
 }
 
 
 Use* AstFactory::createUse(Ident module_name, Ident module_as, Module* module) {
-	return static_cast<Use*>(assignNode(new Use(module_name, module_as, module)));
+	return create<Use>(module_name, module_as, module);
 }
 
 
 Extern* AstFactory::createExtern(Ident name, TypeId type_id) {
-	return static_cast<Extern*>(assignNode(new Extern(name, type_id)));
+	return create<Extern>(name, type_id);
 }
 
 
 Let* AstFactory::createLet(bool is_pub, bool is_mut, Ident name, TypeId type_id, Expr* expr) {
-	return static_cast<Let*>(assignNode(new Let(is_pub, is_mut, name, type_id, expr)));
+	return create<Let>(is_pub, is_mut, name, type_id, expr);
 }
 
 
 ExprEmpty* AstFactory::createExprEmpty() {
-	return static_cast<ExprEmpty*>(assignNode(new ExprEmpty()));
+	return create<ExprEmpty>();
 }
 
 
 ExprBlock* AstFactory::createExprBlock() {
-	return static_cast<ExprBlock*>(assignNode(new ExprBlock()));
+	return create<ExprBlock>(arena());
 }
 
 
 ExprFn* AstFactory::createExprFn(
 		TypeId type_id, const vector<Ident>& args, ExprBlock* body) {
-	return static_cast<ExprFn*>(assignNode(new ExprFn(type_id, args, body)));
+	return create<ExprFn>(arena(), type_id, args, body);
 }
 
 
 ExprIf* AstFactory::createExprIf(Expr* test, Expr* con, Expr* alt) {
-	return static_cast<ExprIf*>(assignNode(new ExprIf(test, con, alt)));
+	return create<ExprIf>(test, con, alt);
 }
 
 
 ExprIdent* AstFactory::createExprIdent(Ident id) {
-	return static_cast<ExprIdent*>(assignNode(new ExprIdent(id)));
+	return create<ExprIdent>(id);
 }
 
 
+// The literal is decoded into the constant table here, once for all later phases.
 ExprLiteral* AstFactory::createExprLiteral(LiteralType lit_type, StrId str_id) {
-	return static_cast<ExprLiteral*>(assignNode(new ExprLiteral(lit_type, str_id)));
+	ExprLiteral* lit = create<ExprLiteral>(lit_type, str_id);
+	lit->const_id(_session->const_table()->addLiteral(lit_type, str_id));
+	return lit;
 }
 
 
 ExprMember* AstFactory::createExprMember(Expr* object, Property property) {
-	return static_cast<ExprMember*>(assignNode(new ExprMember(object, property)));
+	return create<ExprMember>(object, property);
 }
 
 
 ExprCall* AstFactory::createExprCall(Expr* callee, const vector<Expr*>& args) {
-	return static_cast<ExprCall*>(assignNode(new ExprCall(callee, args)));
+	return create<ExprCall>(arena(), callee, args);
 }
 
 
 ExprUnary* AstFactory::createExprUnary(UnaryOp op, Expr* expr) {
-	return static_cast<ExprUnary*>(assignNode(new ExprUnary(op, expr)));
+	return create<ExprUnary>(op, expr);
 }
 
 
 ExprBinary* AstFactory::createExprBinary(BinaryOp op, Expr* left, Expr* right) {
-	return static_cast<ExprBinary*>(assignNode(new ExprBinary(op, left, right)));
+	return create<ExprBinary>(op, left, right);
 }
 
 
 ExprLogical* AstFactory::createExprLogical(LogicalOp op, Expr* left, Expr* right) {
-	return static_cast<ExprLogical*>(assignNode(new ExprLogical(op, left, right)));
+	return create<ExprLogical>(op, left, right);
 }
 
 
 ExprConditional* AstFactory::createExprConditional(Expr* test, Expr* con, Expr* alt) {
-	return static_cast<ExprConditional*>(assignNode(new ExprConditional(test, con, alt)));
+	return create<ExprConditional>(test, con, alt);
 }
 
 
 ExprAssignment* AstFactory::createExprAssignment(AssignmentOp op, Expr* left, Expr* right) {
-	return static_cast<ExprAssignment*>(assignNode(new ExprAssignment(op, left, right)));
+	return create<ExprAssignment>(op, left, right);
 }
 
 
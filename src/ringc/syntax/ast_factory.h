@@ -46,6 +46,19 @@ public:
 protected:
 	AstNode* assignNode(AstNode* node);
 
+	// Returns the AST arena of the session. It is defined out of line, since Session is not
+	// complete yet here.
+	Arena* arena();
+
+	// Creates a node in the AST arena of the session and assigns its id.
+	template <typename T, typename... Args>
+	T* create(Args&&... args) {
+		Arena* arena = this->arena();
+		T* node = new (arena->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		assignNode(node);
+		return node;
+	}
+
 protected:
 	Session* _session;
 };
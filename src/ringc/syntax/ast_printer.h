@@ -13,7 +13,8 @@ namespace ringc {
 namespace ast {
 
 
-class AstPrinter : public AstVisitor {
+class AstPrinter : public AstVisitor<AstPrinter> {
+	friend class AstVisitor<AstPrinter>;
 	ADD_PROPERTY_P(session, Session)
 
 public:
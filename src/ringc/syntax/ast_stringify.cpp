@@ -165,7 +165,7 @@ string AstStringify::toString(Use* use) {
 
 string AstStringify::toString(Extern* ext) {
 	string body =  "Extern ";
-	body += c_Magenta + session()->str(ext->name().name_id()) + c_none + " ";
+	body += c_Magenta + session()->str(ext->name().name_id()).str() + c_none + " ";
 	body += c_Green + "(" + intToString(ext->name().symbol_id().value()) + ")" + c_none;
 	body += c_gray + " : " + toString(ext->type_id()) + c_none;
 	return toStringAst(ext, body);
@@ -182,7 +182,7 @@ string AstStringify::toString(Let* let) {
 	string body = "Let ";
 	body += let->is_pub() ? "pub " : "";
 	body += let->is_mut() ? "mut " : "";
-	body += c_Magenta + session()->str(let->name().name_id()) + c_none + " ";
+	body += c_Magenta + session()->str(let->name().name_id()).str() + c_none + " ";
 	body += c_Green + "(" + intToString(let->name().symbol_id().value()) + ")" + c_none;
 	body += c_gray + " : " + toString(let->type_id()) + c_none;
 	return toStringAst(let, body);
@@ -217,7 +217,7 @@ string AstStringify::toString(ExprIf* if_) {
 
 string AstStringify::toString(ExprIdent* ident) {
 	string body = "ExprIdent ";
-	body += c_magenta + session()->str(ident->id().name_id()) + c_none;
+	body += c_magenta + session()->str(ident->id().name_id()).str() + c_none;
 	body += " " + c_green + "(" + intToString(ident->id().symbol_id().value()) + ")" + c_none;
 	return toStringExpr(ident, body);
 }
@@ -225,7 +225,7 @@ string AstStringify::toString(ExprIdent* ident) {
 
 string AstStringify::toString(ExprLiteral* literal) {
 	string body = "ExprLiteral ";
-	body += c_magenta + session()->str(literal->str_id()) + c_none;
+	body += c_magenta + session()->str(literal->str_id()).str() + c_none;
 	return toStringExpr(literal, body);
 }
 
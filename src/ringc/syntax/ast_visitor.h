@@ -2,15 +2,18 @@
 #define RING_RINGC_SYNTAX_AST_VISITOR_H
 
 
+#include <algorithm>
+#include <cassert>
 #include "ast.h"
 using namespace ring::ringc::ast;
+using namespace std;
 
 
 #define VISIT_ON_PRE(type, value) \
 	if (_terminate) { return; }\
 	_skip_children = false;\
-	onVisitPreNode(value);\
-	onVisitPre##type(value);\
+	derived()->onVisitPreNode(value);\
+	derived()->onVisitPre##type(value);\
 	if (_skip_children) { return ; }\
 
 
@@ -21,16 +24,16 @@ using namespace ring::ringc::ast;
 
 #define VISIT_ON_POST(type, value) \
 	if (_terminate) { return; }\
-	onVisitPost##type(value);\
-	onVisitPostNode(value);\
+	derived()->onVisitPost##type(value);\
+	derived()->onVisitPostNode(value);\
 
 
-#define ADD_VISITOR_PRE(type) virtual void onVisitPre##type(type *)
+#define ADD_VISITOR_PRE(type) void onVisitPre##type(type *)
 
-#define ADD_VISITOR_POST(type) virtual void onVisitPost##type(type *)
+#define ADD_VISITOR_POST(type) void onVisitPost##type(type *)
 
 #define ADD_VISITOR(type)\
-	virtual void visit##type(type *);\
+	void visit##type(type *);\
 	ADD_VISITOR_PRE(type) {}\
 	ADD_VISITOR_POST(type) {}
 
@@ -40,11 +43,16 @@ namespace ringc {
 namespace ast {
 
 
+// AstVisitor walks an AST, calling the handlers of `Derived` before and after the children of each
+// node. The handlers are bound statically: a pass derives from AstVisitor<Pass> and hides the
+// handlers it needs, and the empty ones of the base are inlined away. A pass which declares its
+// handlers protected should befriend AstVisitor<Pass>.
+template <typename Derived>
 class AstVisitor {
 public:
 	AstVisitor();
 
-	virtual void visit(AstNode* node);
+	void visit(AstNode* node);
 
 protected:
 	ADD_VISITOR(Module)
@@ -67,16 +75,18 @@ protected:
 	ADD_VISITOR(ExprConditional)
 	ADD_VISITOR(ExprAssignment)
 
-	virtual void skipChildren();
-	virtual void terminate();
+	void skipChildren();
+	void terminate();
 
 	// Called when before visit children node.
 	// This handler will be called before type specific handler.
-	virtual void onVisitPreNode(AstNode* node) {}
+	void onVisitPreNode(AstNode* node) {}
 
 	// Called when after visit children node.
 	// This handler will be called after type specific handler.
-	virtual void onVisitPostNode(AstNode* node) {}
+	void onVisitPostNode(AstNode* node) {}
+
+	Derived* derived() { return static_cast<Derived*>(this); }
 
 protected:
 	bool _skip_children;
@@ -84,6 +94,260 @@ protected:
 };
 
 
+template <typename Derived>
+AstVisitor<Derived>::AstVisitor()
+		: _skip_children(false)
+		, _terminate(false) {
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::skipChildren() {
+	_skip_children = true;
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::terminate() {
+	_terminate = true;
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visit(AstNode* node) {
+	if (node->isModule()) {
+		visitModule(static_cast<Module*>(node));
+	} else if (node->isUse()) {
+		visitUse(static_cast<Use*>(node));
+	} else if (node->isStmt()) {
+		visitStmt(static_cast<Stmt*>(node));
+	} else {
+		assert(!"AST node should be one of module, use, or statmemt.");
+	}
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitModule(Module* module) {
+	VISIT_ON_PRE(Module, module)
+
+	for_each(module->uses().begin(), module->uses().end(),
+		[this](Use* use) {
+			VISIT_CHILD(Use, use)
+		});
+	for_each(module->exts().begin(), module->exts().end(),
+		[this](Extern* ext) {
+			VISIT_CHILD(Extern, ext)
+		});
+	for_each(module->decls().begin(), module->decls().end(),
+		[this](Let* decl) {
+			VISIT_CHILD(Let, decl)
+		});
+
+	VISIT_ON_POST(Module, module)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitUse(Use* use) {
+	VISIT_ON_PRE(Use, use)
+	VISIT_ON_POST(Use, use)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExtern(Extern* ext) {
+	VISIT_ON_PRE(Extern, ext);
+	VISIT_ON_POST(Extern, ext);
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitStmt(Stmt* stmt) {
+	if (stmt->isLet()) {
+		visitLet(static_cast<Let*>(stmt));
+	} else if (stmt->isExpr()) {
+		visitExpr(static_cast<Expr*>(stmt));
+	} else {
+		assert(!"Statement node should be one of let binding or expression.");
+	}
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitLet(Let* let) {
+	VISIT_ON_PRE(Let, let)
+	VISIT_CHILD(Expr, let->expr())
+	VISIT_ON_POST(Let, let)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExpr(Expr* expr) {
+	switch (expr->node_type()) {
+		case AST_EXPR_EMPTY:
+			visitExprEmpty(static_cast<ExprEmpty*>(expr));
+			return;
+		case AST_EXPR_BLOCK:
+			visitExprBlock(static_cast<ExprBlock*>(expr));
+			return;
+		case AST_EXPR_FN:
+			visitExprFn(static_cast<ExprFn*>(expr));
+			return;
+		case AST_EXPR_IF:
+			visitExprIf(static_cast<ExprIf*>(expr));
+			return;
+		case AST_EXPR_IDENT:
+			visitExprIdent(static_cast<ExprIdent*>(expr));
+			return;
+		case AST_EXPR_LITERAL:
+			visitExprLiteral(static_cast<ExprLiteral*>(expr));
+			return;
+		case AST_EXPR_MEMBER:
+			visitExprMember(static_cast<ExprMember*>(expr));
+			return;
+		case AST_EXPR_CALL:
+			visitExprCall(static_cast<ExprCall*>(expr));
+			return;
+		case AST_EXPR_UNARY:
+			visitExprUnary(static_cast<ExprUnary*>(expr));
+			return;
+		case AST_EXPR_BINARY:
+			visitExprBinary(static_cast<ExprBinary*>(expr));
+			return;
+		case AST_EXPR_LOGICAL:
+			visitExprLogical(static_cast<ExprLogical*>(expr));
+			return;
+		case AST_EXPR_CONDITIONAL:
+			visitExprConditional(static_cast<ExprConditional*>(expr));
+			return;
+		case AST_EXPR_ASSIGNMENT:
+			visitExprAssignment(static_cast<ExprAssignment*>(expr));
+			return;
+	}
+	assert(!"Unknown expression");
+}
+
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprEmpty(ExprEmpty* empty) {
+	VISIT_ON_PRE(ExprEmpty, empty)
+	VISIT_ON_POST(ExprEmpty, empty)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprBlock(ExprBlock* block) {
+	VISIT_ON_PRE(ExprBlock, block)
+	for_each (block->stmts().begin(), block->stmts().end(), [this] (Stmt* stmt) {
+		VISIT_CHILD(Stmt, stmt)
+	});
+	VISIT_ON_POST(ExprBlock, block)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprFn(ExprFn* fn) {
+	VISIT_ON_PRE(ExprFn, fn)
+	VISIT_CHILD(ExprBlock, fn->body())
+	VISIT_ON_POST(ExprFn, fn)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprIf(ExprIf* if_) {
+	VISIT_ON_PRE(ExprIf, if_)
+	VISIT_CHILD(Expr, if_->test())
+	VISIT_CHILD(Expr, if_->con())
+	if (if_->alt()) {
+		VISIT_CHILD(Expr, if_->alt())
+	}
+	VISIT_ON_POST(ExprIf, if_)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprIdent(ExprIdent* ident) {
+	VISIT_ON_PRE(ExprIdent, ident)
+	VISIT_ON_POST(ExprIdent, ident)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprLiteral(ExprLiteral* lit) {
+	VISIT_ON_PRE(ExprLiteral, lit)
+	VISIT_ON_POST(ExprLiteral, lit)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprMember(ExprMember* member) {
+	VISIT_ON_PRE(ExprMember, member)
+	VISIT_CHILD(Expr, member->object())
+	if (member->property().isIndex()) {
+		VISIT_CHILD(Expr, member->property().index())
+	}
+	VISIT_ON_POST(ExprMember, member)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprCall(ExprCall* call) {
+	VISIT_ON_PRE(ExprCall, call)
+	VISIT_CHILD(Expr, call->callee())
+	for_each (call->args().begin(), call->args().end(), [this] (Expr* arg) {
+		VISIT_CHILD(Expr, arg)
+	});
+	VISIT_ON_POST(ExprCall, call)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprUnary(ExprUnary* unary) {
+	VISIT_ON_PRE(ExprUnary, unary)
+	VISIT_CHILD(Expr, unary->expr())
+	VISIT_ON_POST(ExprUnary, unary)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprBinary(ExprBinary* binary) {
+	VISIT_ON_PRE(ExprBinary, binary)
+	VISIT_CHILD(Expr, binary->left())
+	VISIT_CHILD(Expr, binary->right())
+	VISIT_ON_POST(ExprBinary, binary)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprLogical(ExprLogical* logical) {
+	VISIT_ON_PRE(ExprLogical, logical)
+	VISIT_CHILD(Expr, logical->left())
+	VISIT_CHILD(Expr, logical->right())
+	VISIT_ON_POST(ExprLogical, logical)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprConditional(ExprConditional* condition) {
+	VISIT_ON_PRE(ExprConditional, condition)
+	VISIT_CHILD(Expr, condition->test())
+	VISIT_CHILD(Expr, condition->con())
+	VISIT_CHILD(Expr, condition->alt())
+	VISIT_ON_POST(ExprConditional, condition)
+}
+
+
+template <typename Derived>
+void AstVisitor<Derived>::visitExprAssignment(ExprAssignment* assign) {
+	VISIT_ON_PRE(ExprAssignment, assign)
+	VISIT_CHILD(Expr, assign->left())
+	VISIT_CHILD(Expr, assign->right())
+	VISIT_ON_POST(ExprAssignment, assign)
+}
+
+
 } // namespace ast
 } // namespace ringc
 } // namespace ring
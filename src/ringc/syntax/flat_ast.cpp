@@ -0,0 +1,219 @@
+#include "flat_ast.h"
+using namespace ring::ringc::ast;
+using namespace std;
+
+
+FlatIndex FlatAst::nextSibling(FlatIndex child) const {
+	FlatIndex parent = _parents[child];
+	if (parent == FLAT_NONE || _ends[child] >= _ends[parent]) {
+		return FLAT_NONE;
+	}
+	return _ends[child];
+}
+
+
+FlatIndex FlatAst::numChildren(FlatIndex ix) const {
+	FlatIndex n = 0;
+	for (FlatIndex c = firstChild(ix); c != FLAT_NONE; c = nextSibling(c)) {
+		++n;
+	}
+	return n;
+}
+
+
+FlatIndex FlatAst::child(FlatIndex ix, FlatIndex n) const {
+	FlatIndex c = firstChild(ix);
+	for (; c != FLAT_NONE && n > 0; --n) {
+		c = nextSibling(c);
+	}
+	return c;
+}
+
+
+Ident FlatAst::arg(FlatIndex fn, FlatIndex n) const {
+	FlatIndex ix = _auxes[fn] + n;
+	return Ident(_arg_names[ix], _arg_symbol_ids[ix]);
+}
+
+
+size_t FlatAst::memoryUsage() const {
+	return _kinds.capacity() * sizeof(uint8_t) + _subs.capacity() * sizeof(uint8_t) +
+		_parents.capacity() * sizeof(FlatIndex) + _ends.capacity() * sizeof(FlatIndex) +
+		_names.capacity() * sizeof(int32_t) + _auxes.capacity() * sizeof(int32_t) +
+		_node_ids.capacity() * sizeof(NodeId) + _type_ids.capacity() * sizeof(TypeId) +
+		_symbol_ids.capacity() * sizeof(SymbolId) +
+		_arg_names.capacity() * sizeof(NameId) + _arg_symbol_ids.capacity() * sizeof(SymbolId);
+}
+
+
+// Adds a node without children; its end is set when its children are added.
+FlatIndex FlatAst::add(AstNode* node, FlatIndex parent) {
+	FlatIndex ix = length();
+	TypeId type_id;
+	if (node->isExpr()) {
+		type_id = static_cast<Expr*>(node)->type_id();
+	} else if (node->isLet()) {
+		type_id = static_cast<Let*>(node)->type_id();
+	} else if (node->isExtern()) {
+		type_id = static_cast<Extern*>(node)->type_id();
+	}
+	_kinds.push_back(node->node_type());
+	_subs.push_back(0);
+	_parents.push_back(parent);
+	_ends.push_back(ix + 1);
+	_names.push_back(-1);
+	_auxes.push_back(-1);
+	_node_ids.push_back(node->node_id());
+	_type_ids.push_back(type_id);
+	_symbol_ids.push_back(SymbolId());
+	return ix;
+}
+
+
+FlatAstBuilder::FlatAstBuilder(FlatAst* flat)
+		: _flat(flat) {
+}
+
+
+void FlatAstBuilder::build(AstNode* node) {
+	visit(node);
+}
+
+
+void FlatAstBuilder::onVisitPreNode(AstNode* node) {
+	_st.push_back(_flat->add(node, _st.empty() ? FLAT_NONE : _st.back()));
+}
+
+
+void FlatAstBuilder::onVisitPostNode(AstNode* node) {
+	_flat->_ends[_st.back()] = _flat->length();
+	_st.pop_back();
+}
+
+
+void FlatAstBuilder::onVisitPreUse(Use* use) {
+	_flat->_names[_st.back()] = use->module_name().name_id().value();
+	_flat->_auxes[_st.back()] = use->module_as().name_id().value();
+}
+
+
+void FlatAstBuilder::onVisitPreExtern(Extern* ext) {
+	_flat->_names[_st.back()] = ext->name().name_id().value();
+	_flat->_symbol_ids[_st.back()] = ext->name().symbol_id();
+}
+
+
+void FlatAstBuilder::onVisitPreLet(Let* let) {
+	_flat->_names[_st.back()] = let->name().name_id().value();
+	_flat->_subs[_st.back()] = (let->is_pub() ? 1 : 0) | (let->is_mut() ? 2 : 0);
+	_flat->_symbol_ids[_st.back()] = let->name().symbol_id();
+}
+
+
+void FlatAstBuilder::onVisitPreExprFn(ExprFn* fn) {
+	_flat->_names[_st.back()] = fn->args().size();
+	_flat->_auxes[_st.back()] = _flat->_arg_names.size();
+	for (size_t i = 0; i < fn->args().size(); ++i) {
+		_flat->_arg_names.push_back(fn->args()[i].name_id());
+		_flat->_arg_symbol_ids.push_back(fn->args()[i].symbol_id());
+	}
+}
+
+
+void FlatAstBuilder::onVisitPreExprIf(ExprIf* if_) {
+	_flat->_subs[_st.back()] = if_->alt() ? 1 : 0;
+}
+
+
+void FlatAstBuilder::onVisitPreExprIdent(ExprIdent* ident) {
+	_flat->_names[_st.back()] = ident->id().name_id().value();
+	_flat->_symbol_ids[_st.back()] = ident->id().symbol_id();
+}
+
+
+void FlatAstBuilder::onVisitPreExprLiteral(ExprLiteral* lit) {
+	_flat->_names[_st.back()] = lit->str_id().value();
+	_flat->_auxes[_st.back()] = lit->const_id().value();
+	_flat->_subs[_st.back()] = lit->lit_type();
+}
+
+
+void FlatAstBuilder::onVisitPreExprMember(ExprMember* member) {
+	_flat->_subs[_st.back()] = member->property().property_type();
+	if (member->property().isIdent()) {
+		_flat->_names[_st.back()] = member->property().ident().value();
+	}
+}
+
+
+void FlatAstBuilder::onVisitPreExprCall(ExprCall* call) {
+	_flat->_subs[_st.back()] = call->tail() ? 1 : 0;
+}
+
+
+void FlatAstBuilder::onVisitPreExprUnary(ExprUnary* unary) {
+	_flat->_subs[_st.back()] = unary->op();
+}
+
+
+void FlatAstBuilder::onVisitPreExprBinary(ExprBinary* binary) {
+	_flat->_subs[_st.back()] = binary->op();
+}
+
+
+void FlatAstBuilder::onVisitPreExprLogical(ExprLogical* logical) {
+	_flat->_subs[_st.back()] = logical->op();
+}
+
+
+void FlatAstBuilder::onVisitPreExprAssignment(ExprAssignment* assign) {
+	_flat->_subs[_st.back()] = assign->op();
+}
+
+
+FlatAstVisitor::FlatAstVisitor()
+		: _skip_children(false)
+		, _terminate(false) {
+}
+
+
+void FlatAstVisitor::skipChildren() {
+	_skip_children = true;
+}
+
+
+void FlatAstVisitor::terminate() {
+	_terminate = true;
+}
+
+
+// The nodes whose subtrees are open are kept on a stack, and get their post handler called when
+// the scan passes their end. As with AstVisitor, a node whose children are skipped gets none.
+void FlatAstVisitor::visit(const FlatAst& flat, FlatIndex root) {
+	if (root >= flat.length()) {
+		return;
+	}
+	vector<FlatIndex> open;
+	FlatIndex last = flat.end(root);
+	for (FlatIndex ix = root; ix < last; ) {
+		while (!open.empty() && flat.end(open.back()) <= ix) {
+			onVisitPost(flat, open.back());
+			open.pop_back();
+			if (_terminate) { return; }
+		}
+		_skip_children = false;
+		onVisitPre(flat, ix);
+		if (_terminate) { return; }
+		if (_skip_children) {
+			ix = flat.end(ix);
+		} else {
+			open.push_back(ix);
+			++ix;
+		}
+	}
+	while (!open.empty()) {
+		onVisitPost(flat, open.back());
+		open.pop_back();
+		if (_terminate) { return; }
+	}
+}
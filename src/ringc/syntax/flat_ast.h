@@ -0,0 +1,161 @@
+#ifndef RING_RINGC_SYNTAX_FLAT_AST_H
+#define RING_RINGC_SYNTAX_FLAT_AST_H
+
+
+namespace ring {
+namespace ringc {
+namespace ast {
+	class FlatAst;
+	class FlatAstBuilder;
+	class FlatAstVisitor;
+}}}
+
+
+#include <stdint.h>
+#include <vector>
+#include "../../common.h"
+#include "ast.h"
+#include "ast_visitor.h"
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+namespace ast {
+
+
+typedef uint32_t FlatIndex;
+
+const FlatIndex FLAT_NONE = 0xffffffffu;
+
+
+// FlatAst is a compact encoding of an AST subtree.
+// The nodes are laid out in preorder in typed column arrays, and refer to each other by 32-bit
+// indices. The children of a node follow it, and `end` is the index past its last descendant, so
+// the first child of `ix` is `ix + 1`, the next sibling of a child `c` is `end(c)`, and skipping a
+// subtree is a single jump. A walk over the whole tree is a linear scan of the columns.
+//
+// Payloads by kind:
+//   USE                 name: module name,  aux: module alias
+//   EXTERN              name: name
+//   LET                 name: name,         sub: 1 if pub | 2 if mut
+//   EXPR_FN             name: number of arguments, aux: first one in the argument columns
+//   EXPR_IF             sub: 1 if it has an else branch
+//   EXPR_IDENT          name: name
+//   EXPR_LITERAL        name: literal text, aux: constant id, sub: LiteralType
+//   EXPR_MEMBER         name: property ident if sub is PROP_IDENT, otherwise the index is a child
+//   EXPR_CALL           sub: 1 if it is a tail call
+//   EXPR_UNARY, EXPR_BINARY, EXPR_LOGICAL, EXPR_ASSIGNMENT
+//                       sub: operator
+// Types and symbols are side columns; they hold what the resolvers had found when it was built,
+// and FlatTypeResolver fills in the types.
+class FlatAst {
+	friend class FlatAstBuilder;
+
+public:
+	// Returns the number of nodes.
+	FlatIndex length() const { return _kinds.size(); }
+
+	AstNodeType kind(FlatIndex ix) const { return (AstNodeType)_kinds[ix]; }
+	uint8_t sub(FlatIndex ix) const { return _subs[ix]; }
+	FlatIndex parent(FlatIndex ix) const { return _parents[ix]; }
+	FlatIndex end(FlatIndex ix) const { return _ends[ix]; }
+	int32_t name(FlatIndex ix) const { return _names[ix]; }
+	int32_t aux(FlatIndex ix) const { return _auxes[ix]; }
+	NodeId node_id(FlatIndex ix) const { return _node_ids[ix]; }
+	TypeId type_id(FlatIndex ix) const { return _type_ids[ix]; }
+	SymbolId symbol_id(FlatIndex ix) const { return _symbol_ids[ix]; }
+	void type_id(FlatIndex ix, TypeId type_id) { _type_ids[ix] = type_id; }
+
+	// Children.
+	bool hasChildren(FlatIndex ix) const { return _ends[ix] > ix + 1; }
+	FlatIndex firstChild(FlatIndex ix) const { return hasChildren(ix) ? ix + 1 : FLAT_NONE; }
+	FlatIndex nextSibling(FlatIndex child) const;
+	FlatIndex numChildren(FlatIndex ix) const;
+	FlatIndex child(FlatIndex ix, FlatIndex n) const;
+
+	// Arguments of a function.
+	Ident arg(FlatIndex fn, FlatIndex n) const;
+
+	// Returns the bytes of the columns.
+	size_t memoryUsage() const;
+
+protected:
+	FlatIndex add(AstNode* node, FlatIndex parent);
+
+protected:
+	vector<uint8_t> _kinds;
+	vector<uint8_t> _subs;
+	vector<FlatIndex> _parents;
+	vector<FlatIndex> _ends;
+	vector<int32_t> _names;
+	vector<int32_t> _auxes;
+	vector<NodeId> _node_ids;
+	vector<TypeId> _type_ids;
+	vector<SymbolId> _symbol_ids;
+
+	vector<NameId> _arg_names;
+	vector<SymbolId> _arg_symbol_ids;
+};
+
+
+// FlatAstBuilder encodes an AST subtree into a FlatAst.
+class FlatAstBuilder : public AstVisitor<FlatAstBuilder> {
+	friend class AstVisitor<FlatAstBuilder>;
+
+public:
+	FlatAstBuilder(FlatAst* flat);
+
+	void build(AstNode* node);
+
+protected:
+	void onVisitPreNode(AstNode* node);
+	void onVisitPostNode(AstNode* node);
+
+	ADD_VISITOR_PRE(Use);
+	ADD_VISITOR_PRE(Extern);
+	ADD_VISITOR_PRE(Let);
+	ADD_VISITOR_PRE(ExprFn);
+	ADD_VISITOR_PRE(ExprIf);
+	ADD_VISITOR_PRE(ExprIdent);
+	ADD_VISITOR_PRE(ExprLiteral);
+	ADD_VISITOR_PRE(ExprMember);
+	ADD_VISITOR_PRE(ExprCall);
+	ADD_VISITOR_PRE(ExprUnary);
+	ADD_VISITOR_PRE(ExprBinary);
+	ADD_VISITOR_PRE(ExprLogical);
+	ADD_VISITOR_PRE(ExprAssignment);
+
+protected:
+	FlatAst* _flat;
+	vector<FlatIndex> _st;
+};
+
+
+// FlatAstVisitor walks a FlatAst in a linear scan, calling the handlers in the same order as
+// AstVisitor does: pre handler of a node, its children, then its post handler.
+class FlatAstVisitor {
+public:
+	FlatAstVisitor();
+
+	void visit(const FlatAst& flat, FlatIndex root = 0);
+
+protected:
+	virtual void onVisitPre(const FlatAst& flat, FlatIndex ix) {}
+	virtual void onVisitPost(const FlatAst& flat, FlatIndex ix) {}
+
+	void skipChildren();
+	void terminate();
+
+protected:
+	bool _skip_children;
+	bool _terminate;
+};
+
+
+} // namespace ast
+} // namespace ringc
+} // namespace ring
+
+
+#endif
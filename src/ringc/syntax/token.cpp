@@ -1,21 +1,69 @@
 #include "token.h"
+#include <cstring>
 using namespace ring::ringc;
 
 
-static string KEYWORDS[] = {
-	"else",
-	"extern",
-	"fn",
-	"if",
-	"let",
-	"mut",
-	"pub",
-	"then",
-	"this",
-	"use",
+// Keywords and bool literals.
+// They are looked up by a perfect hash of the first char, the last char and the length, which is
+// checked at compile time.
+struct Reserved {
+	const char* str;
+	size_t len;
+	Token::TokenType type;
+};
+
+static constexpr Reserved RESERVED[] = {
+	{ "else", 4, Token::KEYWORD_ELSE },
+	{ "extern", 6, Token::KEYWORD_EXTERN },
+	{ "fn", 2, Token::KEYWORD_FN },
+	{ "if", 2, Token::KEYWORD_IF },
+	{ "let", 3, Token::KEYWORD_LET },
+	{ "mut", 3, Token::KEYWORD_MUT },
+	{ "pub", 3, Token::KEYWORD_PUB },
+	{ "then", 4, Token::KEYWORD_THEN },
+	{ "this", 4, Token::KEYWORD_THIS },
+	{ "use", 3, Token::KEYWORD_USE },
 	// builtin types
-	"int",
-	"nil",
+	{ "int", 3, Token::KEYWORD_TY_INT },
+	{ "nil", 3, Token::KEYWORD_TY_NIL },
+	// bool literals
+	{ "true", 4, Token::LIT_TRUE },
+	{ "false", 5, Token::LIT_FALSE },
+};
+
+static constexpr int NUM_RESERVED = sizeof(RESERVED) / sizeof(RESERVED[0]);
+
+#define RESERVED_HASH_SIZE 32
+
+static constexpr int reservedHash(char first, char last, size_t len) {
+	return (2 * (unsigned char)first + 3 * (unsigned char)last + len) & (RESERVED_HASH_SIZE - 1);
+}
+
+static constexpr int reservedHash(int ix) {
+	return reservedHash(RESERVED[ix].str[0], RESERVED[ix].str[RESERVED[ix].len - 1],
+			RESERVED[ix].len);
+}
+
+// Returns the first reserved word from `ix` whose hash is `hash`, -1 if there is none.
+static constexpr int reservedSlot(int hash, int ix) {
+	return ix == NUM_RESERVED ? -1 : reservedHash(ix) == hash ? ix : reservedSlot(hash, ix + 1);
+}
+
+// Checks that no reserved word from `ix` shares its hash with a later one.
+static constexpr bool isPerfectHash(int ix) {
+	return ix == NUM_RESERVED ||
+		(reservedSlot(reservedHash(ix), ix + 1) == -1 && isPerfectHash(ix + 1));
+}
+
+static_assert(isPerfectHash(0), "Reserved words should have distinct hashes");
+
+#define RESERVED_SLOTS4(h) \
+	reservedSlot(h, 0), reservedSlot(h + 1, 0), reservedSlot(h + 2, 0), reservedSlot(h + 3, 0)
+
+// Index in RESERVED of the word of each hash, -1 if there is none.
+static constexpr int RESERVED_SLOTS[RESERVED_HASH_SIZE] = {
+	RESERVED_SLOTS4(0), RESERVED_SLOTS4(4), RESERVED_SLOTS4(8), RESERVED_SLOTS4(12),
+	RESERVED_SLOTS4(16), RESERVED_SLOTS4(20), RESERVED_SLOTS4(24), RESERVED_SLOTS4(28),
 };
 
 
@@ -150,40 +198,16 @@ string Token::toString() const {
 }
 
 
-Token TokenUtil::maybeKeyword(const string& token_str) {
-	int first_keyword = Token::KEYWORD_ELSE;
-	int last_keyword = Token::KEYWORD_TY_NIL;
-
-	for (int t = first_keyword; t <= last_keyword; ++t) {
-		int ix = t - first_keyword;
-		if (KEYWORDS[ix] == token_str) {
-			return Token((Token::TokenType)t);
-		}
-	}
-	return Token(Token::INVALID);
-}
-
-
-Token TokenUtil::maybeLitBool(const string& str) {
-	if (str == "true") {
-		return Token(Token::LIT_TRUE);
-	} else if (str == "false") {
-		return Token(Token::LIT_FALSE);
-	}
-	return Token(Token::INVALID);
-}
-
-
-Token TokenUtil::reservedOrIdent(const string& str, StrId str_id) {
-	Token res = maybeLitBool(str);
-	if (res.isValid()) {
-		return res;
+Token TokenUtil::maybeReserved(llvm::StringRef str) {
+	if (str.empty()) {
+		return Token(Token::INVALID);
 	}
-	res = maybeKeyword(str);
-	if (res.isValid()) {
-		return res;
+	int slot = RESERVED_SLOTS[reservedHash(str.front(), str.back(), str.size())];
+	if (slot < 0 || RESERVED[slot].len != str.size() ||
+			memcmp(RESERVED[slot].str, str.data(), str.size()) != 0) {
+		return Token(Token::INVALID);
 	}
-	return Token(Token::IDENT, str_id);
+	return Token(RESERVED[slot].type);
 }
 
 
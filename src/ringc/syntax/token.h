@@ -4,6 +4,7 @@
 
 #include <string>
 #include "../../common.h"
+#include "llvm/ADT/StringRef.h"
 using namespace std;
 using namespace ring::ringc;
 
@@ -116,9 +117,8 @@ protected:
 
 class TokenUtil {
 public:
-	static Token maybeKeyword(const string& str);
-	static Token maybeLitBool(const string& str);
-	static Token reservedOrIdent(const string& str, StrId str_id);
+	// Returns the keyword or bool literal token of `str`, or an invalid token if it is none.
+	static Token maybeReserved(llvm::StringRef str);
 
 	static bool isAssigmentOp(Token::TokenType token_type);
 	static bool isLogicalOp(Token::TokenType token_type);
@@ -0,0 +1,21 @@
+#include "token_buffer.h"
+using namespace ring::ringc;
+
+
+void TokenBuffer::push(Token::TokenType type, StrId str_id, uint32_t offset) {
+	_types.push_back(type);
+	_str_ids.push_back(str_id);
+	_offsets.push_back(offset);
+}
+
+
+void TokenBuffer::clear() {
+	_types.clear();
+	_str_ids.clear();
+	_offsets.clear();
+}
+
+
+Token TokenBuffer::token(size_t ix) const {
+	return Token(type(ix), str_id(ix));
+}
@@ -0,0 +1,55 @@
+#ifndef RING_SYNTEX_TOKEN_BUFFER_H
+#define RING_SYNTEX_TOKEN_BUFFER_H
+
+
+namespace ring {
+namespace ringc {
+	class TokenBuffer;
+}}
+
+
+#include <stdint.h>
+#include <vector>
+#include "../../common.h"
+#include "token.h"
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// TokenBuffer holds all the tokens of a source, as a structure of arrays: the types, the string
+// ids and the source offsets are kept in separate arrays which are indexed by the token index.
+// Once filled by Lexer::tokenize(), the last token is EoF and an index past the end reads as the
+// last token, so lookahead needs no bound checks.
+class TokenBuffer {
+public:
+	// Returns the number of tokens, EoF included.
+	size_t length() const { return _types.size(); }
+
+	void push(Token::TokenType type, StrId str_id, uint32_t offset);
+	void clear();
+
+	Token::TokenType type(size_t ix) const { return (Token::TokenType)_types[clamp(ix)]; }
+	StrId str_id(size_t ix) const { return _str_ids[clamp(ix)]; }
+	// Returns the offset of the first character of the token in the source.
+	uint32_t offset(size_t ix) const { return _offsets[clamp(ix)]; }
+
+	Token token(size_t ix) const;
+
+protected:
+	size_t clamp(size_t ix) const { return ix < _types.size() ? ix : _types.size() - 1; }
+
+protected:
+	vector<uint8_t> _types;
+	vector<StrId> _str_ids;
+	vector<uint32_t> _offsets;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
@@ -9,6 +9,7 @@ Trans::Trans(Session* session)
 
 
 llvm::Module* Trans::trans(ast::Module* module) {
+	PhaseTimer timer(session(), "trans");
 	TransIR trans_ir(session());
 	return trans_ir.trans(module);
 }
\ No newline at end of file
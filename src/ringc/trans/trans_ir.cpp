@@ -48,10 +48,17 @@ llvm::Value* TransIR::transUse(ast::Use* use) {
 
 // Translate extern.
 llvm::Value* TransIR::transExtern(ast::Extern* ext) {
-	LOG(LOG_DEBUG, "Trans extern: %s", session()->str(ext->name().name_id()).c_str());
+	LOG(LOG_DEBUG, "Trans extern: %s", session()->str(ext->name().name_id()).data());
 	// Symbol for this let bidning.
-	Symbol* symbol = session()->symbol_table()->value(ext->name().symbol_id());
-	ASSERT_EQ(symbol->llvm_val(), NULL, SRCPOS);
+	Symbol symbol = session()->symbol_table()->value(ext->name().symbol_id());
+	ASSERT_EQ(symbol.llvm_val(), NULL, SRCPOS);
+	return declareExtern(_module, ext);
+}
+
+
+// Declares an extern in `module` and binds its symbol to it.
+llvm::Function* TransIR::declareExtern(llvm::Module* module, ast::Extern* ext) {
+	Symbol symbol = session()->symbol_table()->value(ext->name().symbol_id());
 	// According to its type...
 	if (session()->type_table()->isFuncType(ext->type_id())) {
 		llvm::FunctionType* ll_fn_type = transFunctionType(
@@ -59,9 +66,9 @@ llvm::Value* TransIR::transExtern(ast::Extern* ext) {
 		llvm::Function* ll_fn = llvm::Function::Create(
 				ll_fn_type,
 				llvm::Function::ExternalLinkage,
-				session()->str(symbol->name_id()),
-				_module);
-		symbol->llvm_val(ll_fn);
+				session()->str(symbol.name_id()),
+				module);
+		symbol.llvm_val(ll_fn);
 		return ll_fn;
 	} else {
 		FATAL("Not implemented: transExtern");
@@ -82,12 +89,12 @@ llvm::Value* TransIR::transStmt(ast::Stmt* stmt) {
 // Translate let binding.
 llvm::Value* TransIR::transLet(ast::Let* let) {
 	// Symbol for this let bidning.
-	Symbol* symbol = session()->symbol_table()->value(let->name().symbol_id());
-	ASSERT_EQ(symbol->llvm_val(), NULL, SRCPOS);
+	Symbol symbol = session()->symbol_table()->value(let->name().symbol_id());
+	ASSERT_EQ(symbol.llvm_val(), NULL, SRCPOS);
 	// According to its type...
 	if (session()->type_table()->isFuncType(let->type_id())) {
 		llvm::Function* ll_fn = transExprFn(static_cast<ast::ExprFn*>(let->expr()));
-		ASSERT_EQ(symbol->llvm_val(), ll_fn, SRCPOS);
+		ASSERT_EQ(symbol.llvm_val(), ll_fn, SRCPOS);
 	} else {
 		if (let->inModuleScope()) {
 			FATAL("Not implemented: %s", "top level expression");
@@ -96,7 +103,7 @@ llvm::Value* TransIR::transLet(ast::Let* let) {
 			llvm::AllocaInst* alloca = createEntryBlockAlloca(
 					llvmCurrFn(), let->name().symbol_id());
 			// Set instruction to symbol.
-			ASSERT_EQ(symbol->llvm_val(), alloca, SRCPOS);
+			ASSERT_EQ(symbol.llvm_val(), alloca, SRCPOS);
 			// Initializer.
 			llvm::Value* val = transExprAsRval(let->expr());
 			// Create store instruction.
@@ -191,16 +198,32 @@ llvm::Function* TransIR::transExprFn(ast::ExprFn* fn) {
 	if (fn->parent()->isLet()) {
 		name_id = static_cast<ast::Let*>(fn->parent())->name().name_id();
 	}
+	llvm::Function* ll_fn = declareFn(_module, fn, session()->str(name_id).str());
+	defineFn(fn, ll_fn);
+	return ll_fn;
+}
+
+
+// Declares a function in `module` as `name`.
+// If this function is in a let binding, the symbol of the let binding is bound to it.
+llvm::Function* TransIR::declareFn(llvm::Module* module, ast::ExprFn* fn, const string& name) {
 	// Translate function prototype
+	_module = module;
 	ast::FunctionType* ast_fn_type = session()->type_table()->getFuncType(fn->type_id());
-	llvm::FunctionType* ll_fn_type = transFunctionType(ast_fn_type);
-	llvm::Function* ll_fn = transFunctionProto(ast_fn_type, fn->args(), name_id, true);
+	llvm::Function* ll_fn = transFunctionProto(ast_fn_type, fn->args(), name, true);
 	// If this function is in a let binding, set symbol for it llvm value.
 	if (fn->parent()->isLet()) {
 		ast::Let* let = static_cast<ast::Let*>(fn->parent());
-		Symbol* symbol = session()->symbol_table()->value(let->name().symbol_id());
-		symbol->llvm_val(ll_fn);
+		Symbol symbol = session()->symbol_table()->value(let->name().symbol_id());
+		symbol.llvm_val(ll_fn);
 	}
+	return ll_fn;
+}
+
+
+// Translates the body of a declared function.
+void TransIR::defineFn(ast::ExprFn* fn, llvm::Function* ll_fn) {
+	ast::FunctionType* ast_fn_type = session()->type_table()->getFuncType(fn->type_id());
 	// Create Entry block of the function.
 	llvm::BasicBlock* bb = llvm::BasicBlock::Create(llvmContext(), "entry", ll_fn);
 	_builder.SetInsertPoint(bb);
@@ -214,7 +237,6 @@ llvm::Function* TransIR::transExprFn(ast::ExprFn* fn) {
 	} else {
 		_builder.CreateRet(ll_ret);
 	}
-	return ll_fn;
 }
 
 
@@ -273,21 +295,27 @@ llvm::Value* TransIR::transExprIf(ast::ExprIf* if_) {
 // Identifier expression evaluates l-value.
 llvm::Value* TransIR::transExprIdent(ast::ExprIdent* ident) {
 	// Find symbol.
-	Symbol* symbol = session()->symbol_table()->value(ident->id().symbol_id());
+	Symbol symbol = session()->symbol_table()->value(ident->id().symbol_id());
 	// Debug check invariants.
 	// Symbol should already have been bound with a llvm value.
-	ASSERT_EQ(symbol->name_id(), ident->id().name_id(), SRCPOS);
-	ASSERT_NE(symbol->llvm_val(), NULL, SRCPOS);
+	ASSERT_EQ(symbol.name_id(), ident->id().name_id(), SRCPOS);
+	ASSERT_NE(symbol.llvm_val(), NULL, SRCPOS);
 	// Take coressponding llvm value.
-	llvm::Value* val = symbol->llvm_val();
+	llvm::Value* val = symbol.llvm_val();
 	return val;
 }
 
 
 // Translate literal expression.
 llvm::Value* TransIR::transExprLiteral(ast::ExprLiteral* lit) {
-	switch (lit->lit_type()) {
-		case ast::LIT_NUM: return getConstantInt(lit->str_id());
+	if (lit->const_id().none()) {
+		return NULL;
+	}
+	const Constant& constant = session()->const_table()->value(lit->const_id());
+	switch (constant.type) {
+		case CONST_INT: return getConstantInt(constant.int_value, constant.bits);
+		case CONST_BOOL: return getConstantInt(constant.int_value, 32);
+		case CONST_STRING: break;
 	}
 	return NULL;
 }
@@ -417,15 +445,15 @@ llvm::FunctionType* TransIR::transFunctionType(ast::FunctionType* fn_type) {
 // Translate function prototype.
 llvm::Function* TransIR::transFunctionProto(
 		ast::FunctionType* fn_type,
-		vector<Ident>& args,
-		NameId name_id,
+		ArenaArray<Ident>& args,
+		const string& name,
 		bool is_external) {
 	// Create function.
 	llvm::FunctionType* ll_fn_type = transFunctionType(fn_type);
 	llvm::Function* ll_fn = llvm::Function::Create(
 			ll_fn_type,
 			llvm::Function::ExternalLinkage,
-			session()->str(name_id),
+			name,
 			_module);
 	// Set argument name
 	int idx = 0;
@@ -438,7 +466,7 @@ llvm::Function* TransIR::transFunctionProto(
 
 
 // Translate statments
-llvm::Value* TransIR::transStmts(vector<Stmt*>& stmts) {
+llvm::Value* TransIR::transStmts(ArenaArray<Stmt*>& stmts) {
 	llvm::Value* res = NULL;
 	// Translate each statement.
 	for_each(stmts.begin(), stmts.end(), [this, &res] (Stmt* stmt) {
@@ -452,15 +480,15 @@ llvm::Value* TransIR::transStmts(vector<Stmt*>& stmts) {
 // Create an alloca instr on the function entry.
 llvm::AllocaInst* TransIR::createEntryBlockAlloca(llvm::Function* ll_fn, SymbolId symbol_id) {
 	// Take symbol from symbol table.
-	Symbol* symbol = session()->symbol_table()->value(symbol_id);
-	ASSERT_EQ(symbol->llvm_val(), NULL, SRCPOS);
+	Symbol symbol = session()->symbol_table()->value(symbol_id);
+	ASSERT_EQ(symbol.llvm_val(), NULL, SRCPOS);
 	// Create alloca.
 	llvm::BasicBlock* bb_entry = &ll_fn->getEntryBlock();
 	llvm::IRBuilder<> builder(bb_entry, bb_entry->begin());
 	llvm::AllocaInst* alloca = builder.CreateAlloca(
-			transType(symbol->type_id()), 0, session()->str(symbol->name_id()));
+			transType(symbol.type_id()), 0, session()->str(symbol.name_id()));
 	// Set symbol alloca.
-	symbol->llvm_val(alloca);
+	symbol.llvm_val(alloca);
 	return alloca;
 }
 
@@ -483,22 +511,12 @@ void TransIR::CreateArgumentAllocas(ast::ExprFn* fn, llvm::Function* ll_fn) {
 
 
 // Create constant int value.
-llvm::Constant* TransIR::getConstantInt(int v, int bits, bool is_signed) {
-	LOG(LOG_DEBUG, "Trans constant int: value %d", v);
+llvm::Constant* TransIR::getConstantInt(int64_t v, int bits, bool is_signed) {
+	LOG(LOG_DEBUG, "Trans constant int: value %lld", (long long)v);
 	return llvm::ConstantInt::get(llvm::IntegerType::get(llvmContext(), bits),	v, is_signed);
 }
 
 
-// Create constant int value.
-llvm::Constant* TransIR::getConstantInt(StrId str_id, int bits, uint8_t radix) {
-	LOG(LOG_DEBUG, "Trans constant int: value %s, str_id %d", session()->str(str_id).c_str(), str_id);
-	return llvm::ConstantInt::get(
-			llvm::IntegerType::get(llvmContext(), bits),
-			llvm::StringRef(session()->str(str_id)),
-			radix);
-}
-
-
 llvm::LLVMContext& TransIR::llvmContext() {
 	return llvm::getGlobalContext();
 }
@@ -527,9 +545,9 @@ ExprValType TransIR::exprValType(Expr* expr) {
 			return EXPR_VAL_TYPE_L;
 		case AST_EXPR_IDENT:
 			ExprIdent* ident = static_cast<ExprIdent*>(expr);
-			Symbol* symbol = session()->symbol_table()->value(ident->id().symbol_id());
-			ASSERT_NE(symbol, NULL, SRCPOS);
-			Type* type = session()->type_table()->getType(symbol->type_id());
+			Symbol symbol = session()->symbol_table()->value(ident->id().symbol_id());
+			ASSERT(symbol.isValid(), SRCPOS);
+			Type* type = session()->type_table()->getType(symbol.type_id());
 			ASSERT_NE(type, NULL, SRCPOS);
 			if (type->isFunctionType()) {
 				return EXPR_VAL_TYPE_R;
@@ -26,6 +26,16 @@ public:
 
 	llvm::Module* trans(ast::Module* module);
 
+	// Declares a function of a let binding in `module` as `name`, and binds the symbol of the let
+	// binding to it. Calls to the let binding translated after this call the declared function.
+	llvm::Function* declareFn(llvm::Module* module, ast::ExprFn* fn, const string& name);
+
+	// Translates the body of a declared function.
+	void defineFn(ast::ExprFn* fn, llvm::Function* ll_fn);
+
+	// Declares an extern in `module` and binds its symbol to it.
+	llvm::Function* declareExtern(llvm::Module* module, ast::Extern* ext);
+
 protected:
 	llvm::Module* transModule(ast::Module* module);
 	llvm::Value* transUse(ast::Use* use);
@@ -56,16 +66,15 @@ protected:
 	llvm::FunctionType* transFunctionType(ast::FunctionType* fn_type);
 	llvm::Function* transFunctionProto(
 			ast::FunctionType* fn_type,
-			vector<Ident>& args,
-			NameId name_id = NameId(),
+			ArenaArray<Ident>& args,
+			const string& name,
 			bool is_external = true);
-	llvm::Value* transStmts(vector<Stmt*>& stmts);
+	llvm::Value* transStmts(ArenaArray<Stmt*>& stmts);
 
 	llvm::AllocaInst* createEntryBlockAlloca(llvm::Function* ll_fn, SymbolId symbol_id);
 	void CreateArgumentAllocas(ast::ExprFn* fn, llvm::Function* ll_fn);
 
-	llvm::Constant* getConstantInt(int v, int bits = 32, bool is_signed = false);
-	llvm::Constant* getConstantInt(StrId str_id, int bits = 32, uint8_t radix = 10);
+	llvm::Constant* getConstantInt(int64_t v, int bits = 32, bool is_signed = false);
 
 	llvm::LLVMContext& llvmContext();
 	llvm::Function* llvmCurrFn();
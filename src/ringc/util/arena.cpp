@@ -0,0 +1,54 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+using namespace ring::ringc;
+using namespace std;
+
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+
+Arena::Arena()
+		: _top(NULL)
+		, _end(NULL)
+		, _bytes(0)
+		, _num_allocs(0)
+		, _alloc_bytes(0) {
+}
+
+
+Arena::~Arena() {
+	for_each(_chunks.begin(), _chunks.end(), [](char* chunk) {
+		free(chunk);
+	});
+}
+
+
+void* Arena::allocate(size_t size, size_t align) {
+	size_t pad = (align - reinterpret_cast<size_t>(_top) % align) % align;
+	if (_top == NULL || _top + pad + size > _end) {
+		newChunk(size + align);
+		pad = (align - reinterpret_cast<size_t>(_top) % align) % align;
+	}
+	char* res = _top + pad;
+	_top = res + size;
+	_num_allocs++;
+	_alloc_bytes += size;
+	return res;
+}
+
+
+// A request larger than a chunk gets a chunk of its own.
+void Arena::newChunk(size_t size) {
+	size_t chunk_size = max<size_t>(ARENA_CHUNK_SIZE, size);
+	char* chunk = reinterpret_cast<char*>(malloc(chunk_size));
+	if (chunk == NULL) {
+		fprintf(stderr, "Out of memory: arena\n");
+		exit(EXIT_FAILURE);
+	}
+	_chunks.push_back(chunk);
+	_bytes += chunk_size;
+	_top = chunk;
+	_end = chunk + chunk_size;
+}
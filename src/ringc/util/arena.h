@@ -0,0 +1,124 @@
+#ifndef RING_RINGC_UTIL_ARENA_H
+#define RING_RINGC_UTIL_ARENA_H
+
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// Arena is a bump pointer allocator. Memory is carved out of large chunks and is never freed one
+// by one: the chunks are all released at once when the arena is destroyed, and no destructor of
+// the objects in it runs, so only trivially destructible objects should be put in it.
+class Arena {
+public:
+	Arena();
+	~Arena();
+
+	Arena(const Arena&) = delete;
+	Arena& operator =(const Arena&) = delete;
+
+	void* allocate(size_t size, size_t align);
+
+	template <typename T, typename... Args>
+	T* create(Args&&... args) {
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	template <typename T>
+	T* allocateArray(size_t n) {
+		return reinterpret_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+	}
+
+	// Returns the bytes of the chunks.
+	size_t memoryUsage() const { return _bytes; }
+
+	// Returns the number and the bytes of the allocations made from the arena.
+	int64_t numAllocs() const { return _num_allocs; }
+	int64_t allocBytes() const { return _alloc_bytes; }
+
+protected:
+	void newChunk(size_t size);
+
+protected:
+	vector<char*> _chunks;
+	char* _top;
+	char* _end;
+	size_t _bytes;
+	int64_t _num_allocs;
+	int64_t _alloc_bytes;
+};
+
+
+// ArenaArray is an array of trivially copyable elements whose storage lives in an arena.
+// It grows by doubling into a new block of the arena; the old block is left behind and is released
+// with the arena.
+template <typename T>
+class ArenaArray {
+public:
+	ArenaArray(Arena* arena) : _arena(arena), _data(NULL), _size(0), _capacity(0) {}
+
+	template <typename C>
+	ArenaArray(Arena* arena, const C& elems) : _arena(arena), _data(NULL), _size(0), _capacity(0) {
+		reserve(elems.size());
+		for (auto it = elems.begin(); it != elems.end(); ++it) {
+			_data[_size++] = *it;
+		}
+	}
+
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	iterator begin() { return _data; }
+	iterator end() { return _data + _size; }
+	const_iterator begin() const { return _data; }
+	const_iterator end() const { return _data + _size; }
+
+	size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	T& operator[](size_t ix) { return _data[ix]; }
+	const T& operator[](size_t ix) const { return _data[ix]; }
+	T& back() { return _data[_size - 1]; }
+	const T& back() const { return _data[_size - 1]; }
+
+	void push_back(const T& elem) {
+		if (_size == _capacity) {
+			reserve(_capacity == 0 ? 4 : _capacity * 2);
+		}
+		_data[_size++] = elem;
+	}
+
+	void reserve(size_t capacity) {
+		if (capacity <= _capacity) {
+			return;
+		}
+		T* data = _arena->allocateArray<T>(capacity);
+		if (_size > 0) {
+			memcpy(data, _data, sizeof(T) * _size);
+		}
+		_data = data;
+		_capacity = capacity;
+	}
+
+protected:
+	Arena* _arena;
+	T* _data;
+	size_t _size;
+	size_t _capacity;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
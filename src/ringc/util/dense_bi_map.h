@@ -0,0 +1,103 @@
+#ifndef RING_RINGC_UTIL_DENSE_BI_MAP_H
+#define RING_RINGC_UTIL_DENSE_BI_MAP_H
+
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+#include "id_hash_map.h"
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// DenseIdMap is a map from an id type (see DEF_ID_TYPE) to another id type.
+// Ids are small and dense, so the values are stored in a vector indexed by the key. A key too far
+// past the end of the vector, which would leave most of it empty, goes to a hash map instead.
+template <typename K, typename V>
+class DenseIdMap {
+public:
+	DenseIdMap() : _sparse(V()) {}
+
+	bool contains(K k) const {
+		return get(k).some();
+	}
+
+	// Returns the value of `k`, or none if there is no entry for it.
+	V get(K k) const {
+		int ix = k.value();
+		if (ix >= 0 && ix < (int)_dense.size() && _dense[ix].some()) {
+			return _dense[ix];
+		}
+		return _sparse.length() > 0 ? _sparse.get(k) : V();
+	}
+
+	void set(K k, V v) {
+		assert(k.some() && v.some());
+		int ix = k.value();
+		if (ix >= (int)_dense.size() && ix < 2 * (int)_dense.size() + 64) {
+			_dense.resize(max<size_t>(ix + 1, _dense.size() * 2));
+		}
+		if (ix < (int)_dense.size()) {
+			_dense[ix] = v;
+		} else {
+			_sparse.set(k, v);
+		}
+	}
+
+protected:
+	vector<V> _dense;
+	IdHashMap<K, V> _sparse;
+};
+
+
+// DenseBiMap is a BiMap between two id types.
+// Each direction is a DenseIdMap, so a lookup is an index into a vector for the usual dense ids.
+// The entries are also kept in the order they were added, and can be iterated without copying.
+template <typename L, typename R>
+class DenseBiMap {
+public:
+	typedef vector<pair<L, R> > Entries;
+
+	// Takes the default values like BiMap does; they must be the none ids.
+	DenseBiMap(L default_l, R default_r) {
+		assert(default_l.none() && default_r.none());
+	}
+
+	// Add new entry, returns true if the new entry successfully added. or return false if there
+	// were already the a entry that conatains one of each `lv` or `rv` in the map.
+	bool add(L lv, R rv) {
+		if (containsL(lv) || containsR(rv)) return false;
+		_l_to_r.set(lv, rv);
+		_r_to_l.set(rv, lv);
+		_entries.push_back(make_pair(lv, rv));
+		return true;
+	}
+
+	bool containsL(L v) const { return _l_to_r.contains(v); }
+	bool containsR(R v) const { return _r_to_l.contains(v); }
+
+	// Returns mapped value, or none if there is no such mapping.
+	R fromL(L v) const { return _l_to_r.get(v); }
+	L fromR(R v) const { return _r_to_l.get(v); }
+
+	// Returns the entries in the order they were added.
+	const Entries& entries() const { return _entries; }
+
+	size_t size() const { return _entries.size(); }
+
+protected:
+	DenseIdMap<L, R> _l_to_r;
+	DenseIdMap<R, L> _r_to_l;
+	Entries _entries;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
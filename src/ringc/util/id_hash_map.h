@@ -0,0 +1,140 @@
+#ifndef RING_RINGC_UTIL_ID_HASH_MAP_H
+#define RING_RINGC_UTIL_ID_HASH_MAP_H
+
+
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// IdHashMap is a flat hash map from an id type (see DEF_ID_TYPE) to a value.
+// The entries are kept in one array, addressed by open addressing with linear probing. Ids are
+// non-negative, so a slot holding the none id, which a default constructed id is, is empty.
+// Entries are never removed; a value can be overwritten instead.
+template <typename K, typename V>
+class IdHashMap {
+public:
+	IdHashMap(V default_v = V());
+
+	// Returns the number of entries.
+	int length() const { return _length; }
+
+	// Returns the value of `k`, or the default value if there is no entry for it.
+	V get(K k) const;
+
+	// Returns true if there is an entry for `k`.
+	bool contains(K k) const;
+
+	// Adds or overwrites the entry for `k`.
+	void set(K k, V v);
+
+	// Calls `f(k, v)` for every entry.
+	template <typename F>
+	void forEach(F f) const;
+
+protected:
+	struct Entry {
+		K k;
+		V v;
+	};
+
+	// Fibonacci hashing spreads dense ids over the table.
+	size_t slotOf(K k) const {
+		return (size_t)(((uint32_t)k.value() * 2654435769u) >> (32 - _bits));
+	}
+
+	size_t find(K k) const;
+	void grow();
+
+protected:
+	vector<Entry> _entries;
+	int _bits;
+	int _length;
+	V _default_v;
+};
+
+
+template <typename K, typename V>
+IdHashMap<K, V>::IdHashMap(V default_v)
+		: _entries(8)
+		, _bits(3)
+		, _length(0)
+		, _default_v(default_v) {
+}
+
+
+// Returns the slot of `k`, which is empty if there is no entry for it.
+template <typename K, typename V>
+size_t IdHashMap<K, V>::find(K k) const {
+	size_t mask = _entries.size() - 1;
+	size_t slot = slotOf(k);
+	while (_entries[slot].k.some() && _entries[slot].k != k) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+
+template <typename K, typename V>
+V IdHashMap<K, V>::get(K k) const {
+	const Entry& entry = _entries[find(k)];
+	return entry.k.some() ? entry.v : _default_v;
+}
+
+
+template <typename K, typename V>
+bool IdHashMap<K, V>::contains(K k) const {
+	return _entries[find(k)].k.some();
+}
+
+
+template <typename K, typename V>
+void IdHashMap<K, V>::set(K k, V v) {
+	size_t slot = find(k);
+	if (_entries[slot].k.none()) {
+		// Keeps the load factor at most a half.
+		if ((_length + 1) * 2 > (int)_entries.size()) {
+			grow();
+			slot = find(k);
+		}
+		_entries[slot].k = k;
+		++_length;
+	}
+	_entries[slot].v = v;
+}
+
+
+template <typename K, typename V>
+template <typename F>
+void IdHashMap<K, V>::forEach(F f) const {
+	for (size_t i = 0; i < _entries.size(); ++i) {
+		if (_entries[i].k.some()) {
+			f(_entries[i].k, _entries[i].v);
+		}
+	}
+}
+
+
+template <typename K, typename V>
+void IdHashMap<K, V>::grow() {
+	vector<Entry> entries;
+	entries.swap(_entries);
+	_entries.resize(entries.size() * 2);
+	++_bits;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		if (entries[i].k.some()) {
+			_entries[find(entries[i].k)] = entries[i];
+		}
+	}
+}
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
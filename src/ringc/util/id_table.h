@@ -0,0 +1,59 @@
+#ifndef RING_RINGC_UTIL_ID_TABLE_H
+#define RING_RINGC_UTIL_ID_TABLE_H
+
+
+#include <vector>
+using namespace std;
+
+
+namespace ring {
+namespace ringc {
+
+
+// IdTable is an append-only table from numerical id to template object.
+// Unlike TableMap it keeps no index from value to id: every add appends a new entry, so adding is
+// a push onto a vector. T may be a pointer or the object itself, stored in place; in the latter
+// case a reference from value() is only good until the next add.
+template <typename ID, typename T>
+class IdTable {
+public:
+	// The first element takes id 0, and is what value() returns for an unknown id.
+	IdTable(const T& first) {
+		_values.push_back(first);
+	}
+
+	// Returns the number of elements on this table.
+	int length() const { return _values.size(); }
+
+	// Appends a value to the table and returns its id.
+	ID add(const T& v) {
+		_values.push_back(v);
+		return ID(length() - 1);
+	}
+
+	// Returns value for the id, or first element if there is no such id.
+	const T& value(ID id) const {
+		if (id.value() < 0 || id.value() >= length()) {
+			return _values[0];
+		} else {
+			return _values[id.value()];
+		}
+	}
+
+	// Returns the bytes of the table itself, not of what the elements point to.
+	size_t memoryUsage() const { return _values.capacity() * sizeof(T); }
+
+	typedef typename std::vector<T>::iterator it_type;
+	it_type begin() { return _values.begin(); }
+	it_type end() { return _values.end(); }
+
+protected:
+	vector<T> _values;
+};
+
+
+} // namespace ringc
+} // namespace ring
+
+
+#endif
@@ -0,0 +1,208 @@
+#include "bytecode.h"
+#include <algorithm>
+using namespace ring::ringi;
+using namespace std;
+
+
+const char* InstrUtil::opName(OpCode op) {
+	static const char* names[] = {
+		"NOP",
+		"MOVE",
+		"LOADK",
+		"LOADNIL",
+		"GETGLOBAL",
+		"SETGLOBAL",
+		"ADD",
+		"SUB",
+		"MUL",
+		"DIV",
+		"EXP",
+		"EQ",
+		"NE",
+		"LT",
+		"LE",
+		"GE",
+		"GT",
+		"JMP",
+		"JMPT",
+		"JMPF",
+		"CALL",
+		"TAILCALL",
+		"RET",
+		"ADDK",
+		"SUBK",
+		"JCMP",
+		"JCMPK",
+		"ADD_II",
+		"SUB_II",
+		"MUL_II",
+	};
+	if (op < 0 || op >= NUM_OPCODES) {
+		return "UNKNOWN";
+	}
+	return names[op];
+}
+
+
+const char* InstrUtil::cmpName(int kind) {
+	static const char* names[] = { "eq", "ne", "lt", "le", "ge", "gt" };
+	if (kind < CMP_EQ || kind > CMP_GT) {
+		return "unknown";
+	}
+	return names[kind];
+}
+
+
+FnProto::FnProto(NodeId node_id, const string& name, int num_args)
+		: _node_id(node_id)
+		, _name(name)
+		, _num_args(num_args)
+		, _num_regs(num_args)
+		, _hotness(0)
+		, _jit_fn(NULL)
+		, _jit_failed(false) {
+}
+
+
+int FnProto::emit(Instr instr) {
+	_code.push_back(instr);
+	return _code.size() - 1;
+}
+
+
+int FnProto::addConst(Value value) {
+	for (int i = 0; i < _consts.size(); ++i) {
+		if (_consts[i] == value) {
+			return i;
+		}
+	}
+	_consts.push_back(value);
+	return _consts.size() - 1;
+}
+
+
+int FnProto::addCallCache() {
+	if (_call_caches.size() >= NoCallCache) {
+		return NoCallCache;
+	}
+	CallCache cache = { Value::NoneVal(), NULL };
+	_call_caches.push_back(cache);
+	return _call_caches.size() - 1;
+}
+
+
+void FnProto::print(FILE* fd) const {
+	fprintf(fd, "fn %s (node %d): args %d, regs %d, consts %d\n",
+			name().c_str(), node_id().value(), num_args(), num_regs(), (int)_consts.size());
+	for (int pc = 0; pc < _code.size(); ++pc) {
+		Instr i = _code[pc];
+		OpCode op = InstrUtil::op(i);
+		fprintf(fd, "  %4d  %-10s", pc, InstrUtil::opName(op));
+		switch (op) {
+			case OP_LOADK: {
+					Value k = _consts[InstrUtil::bx(i)];
+					fprintf(fd, "r%d k%d ; %s", InstrUtil::a(i), InstrUtil::bx(i), k.toString().c_str());
+				}
+				break;
+			case OP_GETGLOBAL:
+			case OP_SETGLOBAL:
+				fprintf(fd, "r%d g%d", InstrUtil::a(i), InstrUtil::bx(i));
+				break;
+			case OP_JMP:
+				fprintf(fd, "-> %d", pc + 1 + InstrUtil::sbx(i));
+				break;
+			case OP_JMPT:
+			case OP_JMPF:
+				fprintf(fd, "r%d -> %d", InstrUtil::a(i), pc + 1 + InstrUtil::sbx(i));
+				break;
+			case OP_CALL:
+			case OP_TAILCALL:
+				fprintf(fd, "r%d args %d ic %d", InstrUtil::a(i), InstrUtil::b(i), InstrUtil::c(i));
+				break;
+			case OP_ADDK:
+			case OP_SUBK: {
+					Value k = _consts[InstrUtil::c(i)];
+					fprintf(fd, "r%d r%d k%d ; %s", InstrUtil::a(i), InstrUtil::b(i), InstrUtil::c(i),
+							k.toString().c_str());
+				}
+				break;
+			case OP_JCMP:
+				fprintf(fd, "r%d r%d %s", InstrUtil::a(i), InstrUtil::b(i),
+						InstrUtil::cmpName(InstrUtil::c(i)));
+				break;
+			case OP_JCMPK: {
+					Value k = _consts[InstrUtil::b(i)];
+					fprintf(fd, "r%d k%d %s ; %s", InstrUtil::a(i), InstrUtil::b(i),
+							InstrUtil::cmpName(InstrUtil::c(i)), k.toString().c_str());
+				}
+				break;
+			case OP_LOADNIL:
+			case OP_RET:
+				fprintf(fd, "r%d", InstrUtil::a(i));
+				break;
+			case OP_MOVE:
+				fprintf(fd, "r%d r%d", InstrUtil::a(i), InstrUtil::b(i));
+				break;
+			case OP_NOP:
+				break;
+			default:
+				fprintf(fd, "r%d r%d r%d", InstrUtil::a(i), InstrUtil::b(i), InstrUtil::c(i));
+		}
+		fprintf(fd, "\n");
+	}
+}
+
+
+BytecodeModule::BytecodeModule()
+		: _init(NULL) {
+}
+
+
+BytecodeModule::~BytecodeModule() {
+	for_each(_protos.begin(), _protos.end(), [](FnProto* proto) { delete proto; });
+	for_each(_native_fns.begin(), _native_fns.end(), [](NativeFn* fn) { delete fn; });
+	delete _init;
+}
+
+
+void BytecodeModule::addFnProto(FnProto* proto) {
+	int ix = proto->node_id().value();
+	if (ix >= _fn_protos.size()) {
+		_fn_protos.resize(ix + 1, NULL);
+	}
+	_fn_protos[ix] = proto;
+	_protos.push_back(proto);
+}
+
+
+int BytecodeModule::numGlobals() const {
+	return _global_names.size();
+}
+
+
+NativeFn* BytecodeModule::addNativeFn(NativeFn* fn) {
+	_native_fns.push_back(fn);
+	return fn;
+}
+
+
+// Marks the constants of all functions.
+void BytecodeModule::markRoots(Heap* heap) {
+	auto mark_consts = [heap](FnProto* proto) {
+		for_each(proto->consts().begin(), proto->consts().end(), [heap](Value value) {
+			heap->mark(value);
+		});
+	};
+	for_each(_protos.begin(), _protos.end(), mark_consts);
+	if (_init) {
+		mark_consts(_init);
+	}
+}
+
+
+void BytecodeModule::print(FILE* fd) const {
+	if (_init) {
+		_init->print(fd);
+	}
+	for_each(_protos.begin(), _protos.end(), [fd](FnProto* proto) { proto->print(fd); });
+}
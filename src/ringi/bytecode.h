@@ -0,0 +1,208 @@
+#ifndef RING_RINGI_BYTECODE_H
+#define RING_RINGI_BYTECODE_H
+
+
+namespace ring {
+namespace ringi {
+	class FnProto;
+	struct CallCache;
+	class BytecodeModule;
+	struct JitFn;
+}}
+
+
+#include "../common.h"
+#include "../ringc/session/session.h"
+#include "values.h"
+#include "heap.h"
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+using namespace ring::ringc;
+using namespace std;
+
+
+namespace ring {
+namespace ringi {
+
+
+// Operation codes of the register bytecode.
+// `R[x]` is a register of the current frame, `K[x]` is a constant of the current function and
+// `G[x]` is a module global.
+enum OpCode {
+	OP_NOP,
+	OP_MOVE,        // R[A] = R[B]
+	OP_LOADK,       // R[A] = K[Bx]
+	OP_LOADNIL,     // R[A] = nil
+	OP_GETGLOBAL,   // R[A] = G[Bx]
+	OP_SETGLOBAL,   // G[Bx] = R[A]
+	OP_ADD,         // R[A] = R[B] + R[C]
+	OP_SUB,         // R[A] = R[B] - R[C]
+	OP_MUL,         // R[A] = R[B] * R[C]
+	OP_DIV,         // R[A] = R[B] / R[C]
+	OP_EXP,         // R[A] = R[B] ** R[C]
+	OP_EQ,          // R[A] = R[B] == R[C]
+	OP_NE,          // R[A] = R[B] != R[C]
+	OP_LT,          // R[A] = R[B] < R[C]
+	OP_LE,          // R[A] = R[B] <= R[C]
+	OP_GE,          // R[A] = R[B] >= R[C]
+	OP_GT,          // R[A] = R[B] > R[C]
+	OP_JMP,         // pc += sBx
+	OP_JMPT,        // if R[A] then pc += sBx
+	OP_JMPF,        // if !R[A] then pc += sBx
+	OP_CALL,        // R[A] = R[A](R[A+1], ..., R[A+B]), C is the inline cache of the call site
+	OP_TAILCALL,    // return R[A](R[A+1], ..., R[A+B]), reusing the current frame
+	OP_RET,         // return R[A]
+
+	// Superinstructions. A fused branch is followed by the JMP taken when its test fails.
+	OP_ADDK,        // R[A] = R[B] + K[C]
+	OP_SUBK,        // R[A] = R[B] - K[C]
+	OP_JCMP,        // if !(R[A] <C> R[B]) then do the next JMP else skip it
+	OP_JCMPK,       // if !(R[A] <C> K[B]) then do the next JMP else skip it
+
+	// Quickened forms, rewritten back to the generic op when an operand is not an int.
+	OP_ADD_II,      // R[A] = R[B] + R[C]
+	OP_SUB_II,      // R[A] = R[B] - R[C]
+	OP_MUL_II,      // R[A] = R[B] * R[C]
+	NUM_OPCODES,
+};
+
+
+// Comparisons of the fused branches, in the C operand.
+enum CmpKind {
+	CMP_EQ,
+	CMP_NE,
+	CMP_LT,
+	CMP_LE,
+	CMP_GE,
+	CMP_GT,
+};
+
+
+// An instruction is a 32 bit word:
+//   | op (8) | A (8) | B (8) | C (8) |
+//   | op (8) | A (8) |    Bx / sBx (16)   |
+typedef uint32_t Instr;
+
+
+class InstrUtil {
+public:
+	static const int MaxReg = 0xff;
+	static const int MaxBx = 0xffff;
+	static const int MaxSBx = 0x7fff;
+
+	static Instr ABC(OpCode op, int a, int b, int c) {
+		return op | (a << 8) | (b << 16) | (c << 24);
+	}
+	static Instr ABx(OpCode op, int a, int bx) {
+		return op | (a << 8) | (bx << 16);
+	}
+	static Instr AsBx(OpCode op, int a, int sbx) {
+		return ABx(op, a, sbx + MaxSBx);
+	}
+
+	static OpCode op(Instr i) { return (OpCode)(i & 0xff); }
+	static int a(Instr i) { return (i >> 8) & 0xff; }
+	static int b(Instr i) { return (i >> 16) & 0xff; }
+	static int c(Instr i) { return (i >> 24) & 0xff; }
+	static int bx(Instr i) { return (i >> 16) & 0xffff; }
+	static int sbx(Instr i) { return bx(i) - MaxSBx; }
+
+	// Replaces the sBx operand of a jump instruction.
+	static Instr patchSBx(Instr i, int sbx) {
+		return AsBx(op(i), a(i), sbx);
+	}
+
+	// Replaces the opcode keeping the operands.
+	static Instr patchOp(Instr i, OpCode op) {
+		return (i & ~0xff) | op;
+	}
+
+	static const char* opName(OpCode op);
+	static const char* cmpName(int kind);
+};
+
+
+// Monomorphic inline cache of a call site: the callee seen last and its checked code.
+struct CallCache {
+	Value callee;
+	FnProto* proto;
+};
+
+
+// Compiled code of a function.
+// The first `num_args` registers of a frame hold the arguments of the call.
+class FnProto {
+	ADD_PROPERTY(node_id, NodeId) // AST node of the function, none for the module initializer.
+	ADD_PROPERTY(name, string)
+	ADD_PROPERTY(num_args, int)
+	ADD_PROPERTY(num_regs, int)
+	ADD_PROPERTY_R(code, vector<Instr>)
+	ADD_PROPERTY_R(consts, vector<Value>)
+	ADD_PROPERTY_R(call_caches, vector<CallCache>)
+	ADD_PROPERTY(hotness, int) // Calls and back edges taken, counted until it is compiled.
+	ADD_PROPERTY_P(jit_fn, JitFn) // Native code, NULL while it is interpreted.
+	ADD_PROPERTY(jit_failed, bool) // The JIT can not compile it, so it is never tried again.
+
+public:
+	// Call sites beyond the operand range share no cache and always take the slow path.
+	static const int NoCallCache = InstrUtil::MaxReg;
+
+	FnProto(NodeId node_id, const string& name, int num_args);
+
+	// Appends an instruction and returns its position.
+	int emit(Instr instr);
+
+	// Adds a constant and returns its index.
+	int addConst(Value value);
+
+	// Adds an empty inline cache for a call site and returns its index.
+	int addCallCache();
+
+	void print(FILE* fd) const;
+};
+
+
+// Compiled form of a module: the initializer of the module globals and the compiled functions.
+class BytecodeModule : public GcRoots {
+	ADD_PROPERTY_P(init, FnProto)
+	ADD_PROPERTY_R(global_names, vector<string>)
+
+public:
+	BytecodeModule();
+	~BytecodeModule();
+
+	// Registers the compiled code of the function node `node_id`.
+	void addFnProto(FnProto* proto);
+
+	// Returns the compiled code of the function node `node_id`, NULL if not compiled.
+	FnProto* fnProto(NodeId node_id) const {
+		int ix = node_id.value();
+		return ix >= 0 && ix < _fn_protos.size() ? _fn_protos[ix] : NULL;
+	}
+
+	// Globals are indexed by the module frame slots.
+	int numGlobals() const;
+
+	// Takes the ownership of a native function bound to an extern.
+	NativeFn* addNativeFn(NativeFn* fn);
+
+	// Marks the constants of all functions.
+	void markRoots(Heap* heap);
+
+	void print(FILE* fd) const;
+
+protected:
+	// Indexed by the node id of the function.
+	vector<FnProto*> _fn_protos;
+	vector<FnProto*> _protos;
+	vector<NativeFn*> _native_fns;
+};
+
+
+} // namespace ringi
+} // namespace ring
+
+
+#endif
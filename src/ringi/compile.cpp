@@ -0,0 +1,498 @@
+#include "compile.h"
+#include "../ringc/session/diagnostic.h"
+#include "../ringc/front/symbol.h"
+#include <algorithm>
+#include <dlfcn.h>
+using namespace ring::ringi;
+using namespace ring::ringc;
+using namespace std;
+
+
+Compiler::Compiler(Session* session, BytecodeModule* bc_module, Heap* heap)
+		: _session(session)
+		, _bc_module(bc_module)
+		, _heap(heap)
+		, _fn(NULL)
+		, _module_id()
+		, _int_type_id(session->type_table()->getPrimTypeId(PRIM_TYPE_INT)) {
+}
+
+
+// Compiles a module.
+// Every extern and let binding of the module has a global at its module frame slot. The
+// initializer of the module evaluates the let bindings and stores them into their globals.
+void Compiler::compile(Module* module) {
+	ScopeTracer tracer(session(), "Compiler::compile()");
+	PhaseTimer timer(session(), "bytecode");
+
+	_module_id = module->node_id();
+	_bc_module->global_names().resize(module->frame_size());
+	for_each(module->exts().begin(), module->exts().end(), [this](Extern* ext) {
+		_bc_module->global_names()[globalIndex(ext->name().symbol_id())] =
+			session()->str(ext->name().name_id()).str();
+	});
+	for_each(module->decls().begin(), module->decls().end(), [this](Let* let) {
+		_bc_module->global_names()[globalIndex(let->name().symbol_id())] =
+			session()->str(let->name().name_id()).str();
+	});
+
+	FnState init = { new FnProto(NodeId(), "<init>", 0), 0 };
+	_fn = &init;
+	_bc_module->init(init.proto);
+
+	int reg = allocReg();
+	for_each(module->exts().begin(), module->exts().end(), [this](Extern* ext) {
+		compileExtern(ext);
+	});
+	for_each(module->decls().begin(), module->decls().end(), [this, reg](Let* let) {
+		compileExpr(let->expr(), reg);
+		emit(InstrUtil::ABx(OP_SETGLOBAL, reg, globalIndex(let->name().symbol_id())));
+	});
+	emit(InstrUtil::ABC(OP_LOADNIL, reg, 0, 0));
+	emit(InstrUtil::ABC(OP_RET, reg, 0, 0));
+
+	_fn = NULL;
+}
+
+
+// Compiles a function into a new function prototype and registers it on the module.
+// The prototype is registered before its body is compiled, so that the constants it gets, such
+// as strings on the heap, are roots of a collection made while compiling the rest.
+FnProto* Compiler::compileFn(ExprFn* fn, const string& name) {
+	LOG(LOG_DEBUG, "Compile function %s: node %d", name.c_str(), fn->node_id());
+
+	FnState* outer = _fn;
+	FnState state = { new FnProto(fn->node_id(), name, fn->args().size()), 0 };
+	_bc_module->addFnProto(state.proto);
+	_fn = &state;
+
+	// Arguments and locals occupy the first registers.
+	reserveRegs(fn->frame_size());
+
+	int res = allocReg();
+	compileStmts(fn->body()->stmts(), res);
+	emit(InstrUtil::ABC(OP_RET, res, 0, 0));
+
+	_fn = outer;
+	return state.proto;
+}
+
+
+// Binds an extern to the function of the same name in the host process.
+void Compiler::compileExtern(Extern* ext) {
+	if (!session()->type_table()->isFuncType(ext->type_id())) {
+		FATAL("Not implemented: extern %d which is not a function", ext->node_id());
+	}
+	llvm::StringRef name = session()->str(ext->name().name_id());
+	int num_args = session()->type_table()->getFuncType(ext->type_id())->args().size();
+	void* addr = dlsym(RTLD_DEFAULT, name.data());
+	if (addr == NULL) {
+		LOG(LOG_INFO, "No native function for extern %s", name.data());
+	}
+	int reg = allocReg();
+	NativeFn* native_fn = _bc_module->addNativeFn(new NativeFn(name.str(), num_args, addr));
+	int k = _fn->proto->addConst(Value::Native(native_fn));
+	emit(InstrUtil::ABx(OP_LOADK, reg, k));
+	emit(InstrUtil::ABx(OP_SETGLOBAL, reg, globalIndex(ext->name().symbol_id())));
+	freeRegs(reg);
+}
+
+
+// Compiles statements, the value of the last one goes to `dst`.
+void Compiler::compileStmts(ArenaArray<Stmt*>& stmts, int dst) {
+	if (stmts.empty()) {
+		emit(InstrUtil::ABC(OP_LOADNIL, dst, 0, 0));
+		return;
+	}
+	for (int i = 0; i < stmts.size(); ++i) {
+		if (i + 1 == stmts.size()) {
+			compileStmt(stmts[i], dst);
+		} else if (stmts[i]->isLet()) {
+			compileLet(static_cast<Let*>(stmts[i]));
+		} else {
+			// The value is discarded.
+			int tmp = allocReg();
+			compileExpr(static_cast<Expr*>(stmts[i]), tmp);
+			freeRegs(tmp);
+		}
+	}
+}
+
+
+void Compiler::compileStmt(Stmt* stmt, int dst) {
+	if (stmt->isLet()) {
+		compileLet(static_cast<Let*>(stmt));
+		emit(InstrUtil::ABC(OP_LOADNIL, dst, 0, 0));
+	} else if (stmt->isExpr()) {
+		compileExpr(static_cast<Expr*>(stmt), dst);
+	} else {
+		FATAL("statement %d shoud be either let or expression", stmt->node_id());
+	}
+}
+
+
+// A local let binding lives in the register of its frame slot.
+void Compiler::compileLet(Let* let) {
+	compileExpr(let->expr(), localReg(let->name().symbol_id()));
+}
+
+
+void Compiler::compileExpr(Expr* expr, int dst) {
+	switch (expr->node_type()) {
+		case AST_EXPR_EMPTY:
+			emit(InstrUtil::ABC(OP_LOADNIL, dst, 0, 0));
+			return;
+		case AST_EXPR_BLOCK:
+			compileExprBlock(static_cast<ExprBlock*>(expr), dst);
+			return;
+		case AST_EXPR_FN:
+			compileExprFn(static_cast<ExprFn*>(expr), dst);
+			return;
+		case AST_EXPR_IF:
+			compileExprIf(static_cast<ExprIf*>(expr), dst);
+			return;
+		case AST_EXPR_IDENT:
+			compileExprIdent(static_cast<ExprIdent*>(expr), dst);
+			return;
+		case AST_EXPR_LITERAL:
+			compileExprLiteral(static_cast<ExprLiteral*>(expr), dst);
+			return;
+		case AST_EXPR_CALL:
+			compileExprCall(static_cast<ExprCall*>(expr), dst);
+			return;
+		case AST_EXPR_BINARY:
+			compileExprBinary(static_cast<ExprBinary*>(expr), dst);
+			return;
+		case AST_EXPR_LOGICAL:
+			compileExprLogical(static_cast<ExprLogical*>(expr), dst);
+			return;
+		case AST_EXPR_CONDITIONAL:
+			compileExprConditional(static_cast<ExprConditional*>(expr), dst);
+			return;
+		case AST_EXPR_ASSIGNMENT:
+			compileExprAssignment(static_cast<ExprAssignment*>(expr), dst);
+			return;
+		case AST_EXPR_MEMBER:
+			FATAL("%s", "unimplemented: compileExprMember");
+		case AST_EXPR_UNARY:
+			FATAL("%s", "unimplemented: compileExprUnary");
+	}
+	FATAL("Unknown expression type %d for: expression %d", expr->node_type(), expr->node_id());
+}
+
+
+void Compiler::compileExprBlock(ExprBlock* block, int dst) {
+	int free_reg = _fn->free_reg;
+	compileStmts(block->stmts(), dst);
+	freeRegs(free_reg);
+}
+
+
+void Compiler::compileExprFn(ExprFn* fn, int dst) {
+	string name = "<anonymous>";
+	if (fn->parent() && fn->parent()->isLet()) {
+		name = session()->str(static_cast<Let*>(fn->parent())->name().name_id()).str();
+	}
+	compileFn(fn, name);
+	int k = _fn->proto->addConst(Value::Fn(fn->node_id()));
+	emit(InstrUtil::ABx(OP_LOADK, dst, k));
+}
+
+
+void Compiler::compileExprIf(ExprIf* if_, int dst) {
+	int jmp_alt = compileJumpIfFalse(if_->test());
+
+	compileExpr(if_->con(), dst);
+	int jmp_end = emitJump(OP_JMP, 0);
+
+	patchJump(jmp_alt);
+	if (if_->alt()) {
+		compileExpr(if_->alt(), dst);
+	} else {
+		emit(InstrUtil::ABC(OP_LOADNIL, dst, 0, 0));
+	}
+	patchJump(jmp_end);
+}
+
+
+void Compiler::compileExprIdent(ExprIdent* ident, int dst) {
+	SymbolId symbol_id = ident->id().symbol_id();
+	int reg = localReg(symbol_id);
+	if (reg >= 0) {
+		if (reg != dst) {
+			emit(InstrUtil::ABC(OP_MOVE, dst, reg, 0));
+		}
+	} else {
+		emit(InstrUtil::ABx(OP_GETGLOBAL, dst, globalIndex(symbol_id)));
+	}
+}
+
+
+void Compiler::compileExprLiteral(ExprLiteral* lit, int dst) {
+	Value value = Value::NoneVal();
+	if (lit->const_id().some()) {
+		value = _heap->constValue(session()->const_table()->value(lit->const_id()));
+	}
+	if (value.none()) {
+		FATAL("Unknown literal: lit %d, type %d", lit->node_id(), lit->lit_type());
+	}
+	emit(InstrUtil::ABx(OP_LOADK, dst, _fn->proto->addConst(value)));
+}
+
+
+// The callee and the arguments are placed in consecutive registers, which become the first
+// registers of the callee frame.
+void Compiler::compileExprCall(ExprCall* call, int dst) {
+	int base = allocReg();
+	compileExpr(call->callee(), base);
+	for_each(call->args().begin(), call->args().end(), [this](Expr* arg) {
+		int reg = allocReg();
+		compileExpr(arg, reg);
+		freeRegs(reg + 1);
+	});
+	// A call in tail position returns from the function by itself.
+	OpCode op = call->tail() ? OP_TAILCALL : OP_CALL;
+	emit(InstrUtil::ABC(op, base, call->args().size(), _fn->proto->addCallCache()));
+	if (dst != base && !call->tail()) {
+		emit(InstrUtil::ABC(OP_MOVE, dst, base, 0));
+	}
+	freeRegs(base);
+}
+
+
+void Compiler::compileExprBinary(ExprBinary* binary, int dst) {
+	OpCode op = OP_NOP;
+	switch (binary->op()) {
+		case BO_ADD: op = OP_ADD; break;
+		case BO_SUB: op = OP_SUB; break;
+		case BO_MUL: op = OP_MUL; break;
+		case BO_DIV: op = OP_DIV; break;
+		case BO_EXP: op = OP_EXP; break;
+		case BO_EQ: op = OP_EQ; break;
+		case BO_NE: op = OP_NE; break;
+		case BO_LT: op = OP_LT; break;
+		case BO_LE: op = OP_LE; break;
+		case BO_GE: op = OP_GE; break;
+		case BO_GT: op = OP_GT; break;
+	}
+	if (op == OP_NOP) {
+		FATAL("Unknown operation: %s for: expression %d",
+				AstStringify::toString(binary->op()).c_str(), binary->node_id());
+	}
+
+	int free_reg = _fn->free_reg;
+	int left = compileExprAnyReg(binary->left());
+
+	// An int literal on the right is taken right from the constants.
+	int k = op == OP_ADD || op == OP_SUB ? intConstOperand(binary->right()) : -1;
+	if (k >= 0) {
+		emit(InstrUtil::ABC(op == OP_ADD ? OP_ADDK : OP_SUBK, dst, left, k));
+		freeRegs(free_reg);
+		return;
+	}
+
+	// Arithmetic typed int by the resolver starts quickened. The VM still guards the operands.
+	if (binary->type_id() == _int_type_id) {
+		switch (op) {
+			case OP_ADD: op = OP_ADD_II; break;
+			case OP_SUB: op = OP_SUB_II; break;
+			case OP_MUL: op = OP_MUL_II; break;
+			default: break;
+		}
+	}
+
+	int right = compileExprAnyReg(binary->right());
+	emit(InstrUtil::ABC(op, dst, left, right));
+	freeRegs(free_reg);
+}
+
+
+void Compiler::compileExprLogical(ExprLogical* logical, int dst) {
+	compileExpr(logical->left(), dst);
+	int jmp_end = emitJump(logical->op() == LO_AND ? OP_JMPF : OP_JMPT, dst);
+	compileExpr(logical->right(), dst);
+	patchJump(jmp_end);
+}
+
+
+void Compiler::compileExprConditional(ExprConditional* cond, int dst) {
+	int jmp_alt = compileJumpIfFalse(cond->test());
+
+	compileExpr(cond->con(), dst);
+	int jmp_end = emitJump(OP_JMP, 0);
+	patchJump(jmp_alt);
+	compileExpr(cond->alt(), dst);
+	patchJump(jmp_end);
+}
+
+
+void Compiler::compileExprAssignment(ExprAssignment* assign, int dst) {
+	if (assign->left()->node_type() != AST_EXPR_IDENT) {
+		FATAL("Not implemented: assignment to non identifier: expression %d", assign->node_id());
+	}
+	OpCode op = OP_NOP;
+	switch (assign->op()) {
+		case AO_ASSIGN: op = OP_MOVE; break;
+		case AO_ADD: op = OP_ADD; break;
+		case AO_SUB: op = OP_SUB; break;
+		case AO_MUL: op = OP_MUL; break;
+		case AO_DIV: op = OP_DIV; break;
+	}
+	if (op == OP_NOP) {
+		FATAL("Unknown operation: %s for: expression %d",
+				AstStringify::toString(assign->op()).c_str(), assign->node_id());
+	}
+
+	SymbolId symbol_id = static_cast<ExprIdent*>(assign->left())->id().symbol_id();
+	int free_reg = _fn->free_reg;
+	int value = allocReg();
+	compileExpr(assign->right(), value);
+
+	int reg = localReg(symbol_id);
+	if (reg >= 0) {
+		emit(InstrUtil::ABC(op, reg, op == OP_MOVE ? value : reg, value));
+	} else {
+		int global = globalIndex(symbol_id);
+		if (op != OP_MOVE) {
+			int old = allocReg();
+			emit(InstrUtil::ABx(OP_GETGLOBAL, old, global));
+			emit(InstrUtil::ABC(op, value, old, value));
+		}
+		emit(InstrUtil::ABx(OP_SETGLOBAL, value, global));
+		reg = value;
+	}
+	if (dst != reg) {
+		emit(InstrUtil::ABC(OP_MOVE, dst, reg, 0));
+	}
+	freeRegs(free_reg);
+}
+
+
+int Compiler::compileExprAnyReg(Expr* expr) {
+	if (expr->node_type() == AST_EXPR_IDENT) {
+		int reg = localReg(static_cast<ExprIdent*>(expr)->id().symbol_id());
+		if (reg >= 0) {
+			return reg;
+		}
+	}
+	int reg = allocReg();
+	compileExpr(expr, reg);
+	return reg;
+}
+
+
+int Compiler::allocReg() {
+	int reg = _fn->free_reg;
+	reserveRegs(reg + 1);
+	return reg;
+}
+
+
+// Reserves the registers below `num_regs`.
+void Compiler::reserveRegs(int num_regs) {
+	if (num_regs > InstrUtil::MaxReg + 1) {
+		FATAL("Too many registers for function %s", _fn->proto->name().c_str());
+	}
+	_fn->free_reg = num_regs;
+	_fn->proto->num_regs(max(_fn->proto->num_regs(), num_regs));
+}
+
+
+void Compiler::freeRegs(int free_reg) {
+	_fn->free_reg = free_reg;
+}
+
+
+// Returns the register of a local variable of the current function, -1 if it is not a local.
+int Compiler::localReg(SymbolId symbol_id) {
+	Symbol symbol = session()->symbol_table()->value(symbol_id);
+	return symbol.frame_id() == _fn->proto->node_id() ? symbol.slot() : -1;
+}
+
+
+int Compiler::globalIndex(SymbolId symbol_id) {
+	Symbol symbol = session()->symbol_table()->value(symbol_id);
+	if (symbol.frame_id() != _module_id) {
+		// Locals of enclosing functions are not reachable, closures are not supported yet.
+		FATAL("No register or global for: symbol %d", symbol_id);
+	}
+	return symbol.slot();
+}
+
+
+int Compiler::emit(Instr instr) {
+	return _fn->proto->emit(instr);
+}
+
+
+// Compiles a jump taken when `test` is false and returns its position to be patched.
+// A comparison is fused with the branch, so its result never goes through a register.
+int Compiler::compileJumpIfFalse(Expr* test) {
+	int free_reg = _fn->free_reg;
+	int jmp = -1;
+
+	int cmp = -1;
+	if (test->node_type() == AST_EXPR_BINARY) {
+		switch (static_cast<ExprBinary*>(test)->op()) {
+			case BO_EQ: cmp = CMP_EQ; break;
+			case BO_NE: cmp = CMP_NE; break;
+			case BO_LT: cmp = CMP_LT; break;
+			case BO_LE: cmp = CMP_LE; break;
+			case BO_GE: cmp = CMP_GE; break;
+			case BO_GT: cmp = CMP_GT; break;
+			default: break;
+		}
+	}
+
+	if (cmp >= 0) {
+		ExprBinary* binary = static_cast<ExprBinary*>(test);
+		int left = compileExprAnyReg(binary->left());
+		int k = intConstOperand(binary->right());
+		if (k >= 0) {
+			emit(InstrUtil::ABC(OP_JCMPK, left, k, cmp));
+		} else {
+			int right = compileExprAnyReg(binary->right());
+			emit(InstrUtil::ABC(OP_JCMP, left, right, cmp));
+		}
+		jmp = emitJump(OP_JMP, 0);
+	} else {
+		jmp = emitJump(OP_JMPF, compileExprAnyReg(test));
+	}
+
+	freeRegs(free_reg);
+	return jmp;
+}
+
+
+// Returns the constant index of an int literal for a K operand, -1 if it has none.
+int Compiler::intConstOperand(Expr* expr) {
+	if (expr->node_type() != AST_EXPR_LITERAL) {
+		return -1;
+	}
+	ExprLiteral* lit = static_cast<ExprLiteral*>(expr);
+	if (lit->const_id().none()) {
+		return -1;
+	}
+	Value value = Value::Const(session()->const_table()->value(lit->const_id()));
+	if (!value.isInt()) {
+		return -1;
+	}
+	int k = _fn->proto->addConst(value);
+	return k <= InstrUtil::MaxReg ? k : -1;
+}
+
+
+int Compiler::emitJump(OpCode op, int a) {
+	return emit(InstrUtil::AsBx(op, a, 0));
+}
+
+
+// Patches the jump at `pc` to jump to the next instruction to be emitted.
+void Compiler::patchJump(int pc) {
+	vector<Instr>& code = _fn->proto->code();
+	int offset = code.size() - (pc + 1);
+	if (offset > InstrUtil::MaxSBx) {
+		FATAL("Too long jump in function %s", _fn->proto->name().c_str());
+	}
+	code[pc] = InstrUtil::patchSBx(code[pc], offset);
+}
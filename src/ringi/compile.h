@@ -0,0 +1,96 @@
+#ifndef RING_RINGI_COMPILE_H
+#define RING_RINGI_COMPILE_H
+
+
+namespace ring {
+namespace ringi {
+	class Compiler;
+}}
+
+
+#include "../common.h"
+#include "../ringc/syntax/ast.h"
+#include "../ringc/session/session.h"
+#include "bytecode.h"
+#include "heap.h"
+#include <vector>
+using namespace ring::ringc::ast;
+using namespace ring::ringc;
+using namespace std;
+
+
+namespace ring {
+namespace ringi {
+
+
+// Compiler translates a resolved AST into register bytecode.
+// Every function gets its own frame of registers: the frame slots given by the resolver come
+// first, arguments then locals, and temporaries follow them. Module level slots become globals.
+class Compiler {
+	ADD_PROPERTY_P(session, Session)
+
+public:
+	Compiler(Session* session, BytecodeModule* bc_module, Heap* heap);
+
+	// Compiles a module. The given AST must be pre-resolved.
+	void compile(Module* module);
+
+protected:
+	// Compile state of the function being compiled.
+	struct FnState {
+		FnProto* proto;
+		int free_reg;
+	};
+
+	FnProto* compileFn(ExprFn* fn, const string& name);
+	void compileExtern(Extern* ext);
+
+	void compileStmts(ArenaArray<Stmt*>& stmts, int dst);
+	void compileStmt(Stmt* stmt, int dst);
+	void compileLet(Let* let);
+	void compileExpr(Expr* expr, int dst);
+	void compileExprBlock(ExprBlock* block, int dst);
+	void compileExprFn(ExprFn* fn, int dst);
+	void compileExprIf(ExprIf* if_, int dst);
+	void compileExprIdent(ExprIdent* ident, int dst);
+	void compileExprLiteral(ExprLiteral* lit, int dst);
+	void compileExprCall(ExprCall* call, int dst);
+	void compileExprBinary(ExprBinary* binary, int dst);
+	void compileExprLogical(ExprLogical* logical, int dst);
+	void compileExprConditional(ExprConditional* cond, int dst);
+	void compileExprAssignment(ExprAssignment* assign, int dst);
+
+	// Returns a register that holds the value of `expr`.
+	// Local variables are used in place, other expressions are compiled into a new temporary.
+	int compileExprAnyReg(Expr* expr);
+
+	// Compiles a jump taken when `test` is false and returns its position to be patched.
+	int compileJumpIfFalse(Expr* test);
+
+	// Returns the constant index of an int literal for a K operand, -1 if it has none.
+	int intConstOperand(Expr* expr);
+
+	int allocReg();
+	void freeRegs(int free_reg);
+	int localReg(SymbolId symbol_id);
+	int globalIndex(SymbolId symbol_id);
+	void reserveRegs(int num_regs);
+
+	int emit(Instr instr);
+	int emitJump(OpCode op, int a);
+	void patchJump(int pc);
+
+protected:
+	BytecodeModule* _bc_module;
+	Heap* _heap;
+	FnState* _fn;
+	NodeId _module_id;
+	TypeId _int_type_id;
+};
+
+
+} // namespace ringi
+} // namespace ring
+
+
+#endif
@@ -1,6 +1,7 @@
 #include "eval.h"
 #include "../ringc/session/diagnostic.h"
 #include "../ringc/syntax/ast_stringify.h"
+#include "../ringc/front/symbol.h"
 #include <algorithm>
 using namespace ring::ringi;
 using namespace ring::ringc;
@@ -8,7 +9,9 @@ using namespace std;
 
 
 Evaluator::Evaluator(Interpret* interpret)
-		: _interpret(interpret) {
+		: _interpret(interpret)
+		, _call_caches(interpret->session()->ast_table()->length())
+		, _tail_call(-1) {
 }
 
 
@@ -17,26 +20,21 @@ Session* Evaluator::session() {
 }
 
 
-Environment* Evaluator::currEnv() {
-	return _interpret->env_curr();
+void Evaluator::enterFrame(AstNode* node) {
+	// Create new frame.
+	_interpret->enterFrame(node->node_id());
 }
 
 
-void Evaluator::enterBlock(AstNode* node) {
-	// Create new environment.
-	_interpret->enterBlock(node->node_id());
-}
-
-
-void Evaluator::exitBlock(AstNode* node) {
-	// Exit from environment.
-	_interpret->exitBlock(node->node_id());
+void Evaluator::exitFrame(AstNode* node) {
+	// Exit from frame.
+	_interpret->exitFrame(node->node_id());
 }
 
 
 // Evaluate an AST.
 // The given AST must be pre-resolved and related information should be stacked on the session.
-Value*  Evaluator::evaluate(AstNode* node) {
+Value Evaluator::evaluate(AstNode* node) {
 	if (node->isModule()) {
 		return evalModule(static_cast<Module*>(node));
 	} else if (node->isUse()) {
@@ -50,9 +48,9 @@ Value*  Evaluator::evaluate(AstNode* node) {
 }
 
 
-Value* Evaluator::evalModule(Module* module) {
-	Value* res = Value::Nil();
-	enterBlock(module);
+Value Evaluator::evalModule(Module* module) {
+	Value res = Value::Nil();
+	enterFrame(module);
 
 	for_each(module->uses().begin(), module->uses().end(),
 		[this](Use* use) {
@@ -65,7 +63,7 @@ Value* Evaluator::evalModule(Module* module) {
 
 	if (session()->main().some()) {
 		LOG(LOG_DEBUG,"invoke main function %d", session()->main());
-		vector<Value*> empty_args;
+		vector<Value> empty_args;
 		AstNode* ast_main = session()->ast_table()->value(session()->main());
 		if (!ast_main->isLet()) {
 			FATAL("`main` is not a let binding: %d", ast_main->node_id());
@@ -74,22 +72,23 @@ Value* Evaluator::evalModule(Module* module) {
 		if (!let_main->expr()->isExprFn()) {
 			FATAL("`main` does not hold a function: %d", ast_main->node_id());
 		}
-		ExprFn* expr_main = static_cast<ExprFn*>(let_main->expr());
-		res = evalFnCall(expr_main, empty_args);
+		CallCache cache;
+		fillCallCache(&cache, let_main->expr()->node_id());
+		res = evalFnCall(cache, empty_args);
 	}
 
-	exitBlock(module);
+	exitFrame(module);
 	return res;
 }
 
 
 // TODO:
-Value* Evaluator::evalUse(Use* use) {
+Value Evaluator::evalUse(Use* use) {
 	return Value::Nil();
 }
 
 
-Value* Evaluator::evalStmt(Stmt* stmt) {
+Value Evaluator::evalStmt(Stmt* stmt) {
 	if (stmt->isLet()) {
 		return evalLet(static_cast<Let*>(stmt));
 	} else if (stmt->isExpr()) {
@@ -101,14 +100,14 @@ Value* Evaluator::evalStmt(Stmt* stmt) {
 
 
 // Evaluate let expression.
-Value* Evaluator::evalLet(Let* let) {
-	Value* value = evalExpr(let->expr());
+Value Evaluator::evalLet(Let* let) {
+	Value value = evalExpr(let->expr());
 	_interpret->initSymbol(let->name().symbol_id(), value);
 	return Value::Nil();
 }
 
 
-Value* Evaluator::evalExpr(Expr* expr) {
+Value Evaluator::evalExpr(Expr* expr) {
 	switch (expr->node_type()) {
 		case AST_EXPR_EMPTY:
 			return evalExprEmpty(static_cast<ExprEmpty*>(expr));
@@ -142,64 +141,104 @@ Value* Evaluator::evalExpr(Expr* expr) {
 
 
 // Evaluate empty expression.
-Value* Evaluator::evalExprEmpty(ExprEmpty* empty) {
+Value Evaluator::evalExprEmpty(ExprEmpty* empty) {
 	return Value::Nil();
 }
 
 
 // Evaluate block expression.
-Value* Evaluator::evalExprBlock(ExprBlock* block) {
-	Value* res = Value::Nil();
-	enterBlock(block);
-
+// Symbols of the block live in the frame of the enclosing function.
+Value Evaluator::evalExprBlock(ExprBlock* block) {
+	Value res = Value::Nil();
 	for_each (block->stmts().begin(), block->stmts().end(), [this, &res] (Stmt* stmt) {
 		res = evalStmt(stmt);
 	});
-
-	exitBlock(block);
 	return res;
 }
 
 
-Value* Evaluator::evalExprFn(ExprFn* fn) {
-	return new ValFn(fn->node_id());
+Value Evaluator::evalExprFn(ExprFn* fn) {
+	return Value::Fn(fn->node_id());
 }
 
 
-
-Value* Evaluator::evalFnCall(NodeId fn_node_id, vector<Value*> args) {
-	AstNode* ast_callee = session()->ast_table()->value(fn_node_id);
-	if (ast_callee->isExprFn()) {
-		ExprFn* fn = static_cast<ExprFn*>(ast_callee);
-		return evalFnCall(fn, args);
+// Returns the cache of a call site.
+Evaluator::CallCache& Evaluator::callCache(ExprCall* call) {
+	int ix = call->node_id().value();
+	if (ix >= _call_caches.size()) {
+		_call_caches.resize(ix + 1);
 	}
-	FATAL("Callee is not a function %d", ast_callee->node_id());
+	return _call_caches[ix];
 }
 
 
+// Resolves the function `fn_id` into `cache`. This is the slow path of a call.
+void Evaluator::fillCallCache(CallCache* cache, NodeId fn_id) {
+	AstNode* ast_callee = session()->ast_table()->value(fn_id);
+	if (!ast_callee->isExprFn()) {
+		FATAL("Callee is not a function %d", ast_callee->node_id());
+	}
+	ExprFn* fn = static_cast<ExprFn*>(ast_callee);
+
+	cache->fn_id = fn_id;
+	cache->fn = fn;
+	cache->arg_slots.clear();
+	for_each(fn->args().begin(), fn->args().end(), [this, cache](Ident& arg) {
+		Symbol symbol = session()->symbol_table()->value(arg.symbol_id());
+		cache->arg_slots.push_back(symbol.slot());
+	});
+}
 
-Value* Evaluator::evalFnCall(ExprFn* fn, vector<Value*> args) {
-	Value* res = Value::Nil();
-	enterBlock(fn->body());
 
-	auto arg_list = fn->args();
-	for (int i = 0; i < arg_list.size(); ++i) {
-		_interpret->initSymbol(arg_list[i].symbol_id(), args[i]);
-	}
+// Evaluates a function call.
+// A call in tail position does not recurse: it leaves the callee and its arguments in
+// `_tail_call` and unwinds to here, where the frame of the function is replaced by the frame of
+// the callee. So tail recursion runs in constant native stack.
+Value Evaluator::evalFnCall(const CallCache& cache, const vector<Value>& args) {
+	ExprFn* fn = enterFnFrame(cache, args);
+	Value res = Value::Nil();
+	while (true) {
+		for_each (fn->body()->stmts().begin(), fn->body()->stmts().end(), [this, &res] (Stmt* stmt) {
+			res = this->evalStmt(stmt);
+		});
+		if (_tail_call < 0) {
+			break;
+		}
 
-	for_each (fn->body()->stmts().begin(), fn->body()->stmts().end(), [this, &res] (Stmt* stmt) {
-		res = this->evalStmt(stmt);
-	});
+		// Nothing allocates until the arguments are in the new frame.
+		int tail_call = _tail_call;
+		_tail_call = -1;
+		exitFrame(fn);
+		fn = enterFnFrame(_call_caches[tail_call], _tail_args);
+	}
 
-	exitBlock(fn->body());
+	exitFrame(fn);
 	return res;
 }
 
 
-Value* Evaluator::evalExprIf(ExprIf* if_) {
-	Value* test = evalExpr(if_->test());
-	ValBool* btest = dynamic_cast<ValBool*>(test);
-	if (btest->value()) {
+// Pushes the frame of a call and stores the arguments right into its slots.
+ExprFn* Evaluator::enterFnFrame(const CallCache& cache, const vector<Value>& args) {
+	ExprFn* fn = cache.fn;
+	if (args.size() != cache.arg_slots.size()) {
+		FATAL("Function %d takes %d arguments, but %d given",
+				fn->node_id(), (int)cache.arg_slots.size(), (int)args.size());
+	}
+
+	_interpret->enterFrame(fn->node_id(), fn->frame_size());
+	for (int i = 0; i < args.size(); ++i) {
+		_interpret->initSlot(cache.arg_slots[i], args[i]);
+	}
+	return fn;
+}
+
+
+Value Evaluator::evalExprIf(ExprIf* if_) {
+	Value test = evalExpr(if_->test());
+	if (!test.isBool()) {
+		FATAL("Condition expected to be bool type: expression %d", if_->test()->node_id());
+	}
+	if (test.asBool()) {
 		return evalExpr(if_->con());
 	} else if (if_->alt()) {
 		return evalExpr(if_->alt());
@@ -211,102 +250,119 @@ Value* Evaluator::evalExprIf(ExprIf* if_) {
 // Evaluate ident expression.
 // Find the definition of this ident in lexical scoping structure.(It was done in resolve phase)
 // And get the value of that variable from environment.
-Value* Evaluator::evalExprIdent(ExprIdent* ident) {
-	Value* value = _interpret->getValueFromEnv(ident->id().symbol_id());
+Value Evaluator::evalExprIdent(ExprIdent* ident) {
+	Value value = _interpret->getSymbolValue(ident->id().symbol_id());
 	LOG(LOG_DEBUG, "symbol %s has value %s",
-			session()->str_table()->value(ident->id().name_id()).c_str(),
-			value->toString().c_str());
+			session()->str_table()->value(ident->id().name_id()).data(),
+			value.toString().c_str());
 	return value;
 }
 
 
 // Evaluate literal expression.
-// Create a Value instance depends on the AST,
-Value* Evaluator::evalExprLiteral(ExprLiteral* lit) {
-	string val = session()->str_table()->value(lit->str_id());
-
-	// Create new value according to literal.
-	Value* new_value = Value::NoneVal();
-	switch (lit->lit_type()) {
-		case LIT_FALSE: new_value = ValBool::False(); break;
-		case LIT_TRUE: new_value = ValBool::True(); break;
-		case LIT_CHAR: break;
-		case LIT_STRING: break;
-		case LIT_NUM: new_value = new ValInt(val); break;
+// The literal was decoded into the constant table when it was parsed.
+Value Evaluator::evalExprLiteral(ExprLiteral* lit) {
+	Value new_value = Value::NoneVal();
+	if (lit->const_id().some()) {
+		const Constant& constant = session()->const_table()->value(lit->const_id());
+		new_value = _interpret->heap()->constValue(constant);
 	}
-	if (new_value == Value::NoneVal()) {
+	if (new_value.none()) {
 		FATAL("Unknown literal: lit %d, type %d, value %s",
-				lit->node_id(), lit->lit_type(), val.c_str());
+				lit->node_id(), lit->lit_type(), session()->str(lit->str_id()).data());
 	}
 
-	LOG(LOG_DEBUG, "literal value %s", new_value->toString().c_str());
+	LOG(LOG_DEBUG, "literal value %s", new_value.toString().c_str());
 	return new_value;
 }
 
 
 // TODO: Evaluate member expression.
-Value* Evaluator::evalExprMember(ExprMember* member) {
+Value Evaluator::evalExprMember(ExprMember* member) {
 	FATAL("%s", "unimplemented: evalEmprMember");
 }
 
 // Evaluates call expression.
-Value* Evaluator::evalExprCall(ExprCall* call) {
+Value Evaluator::evalExprCall(ExprCall* call) {
 	// Evaluate callee.
-	Value* callee = evalExpr(call->callee());
-	if (callee->value_type() != VALUE_FN) {
-		FATAL("Callee expected to be function type(%d), but (%d)", VALUE_FN, callee->value_type());
+	Value callee = evalExpr(call->callee());
+	if (!callee.isFn()) {
+		FATAL("Callee expected to be function type(%d), but (%d)", VALUE_FN, callee.value_type());
 	}
 
 	// Evaluate arguemnts
-	vector<Value*> args;
+	// Evaluated arguments are protected until they are in the frame of the callee.
+	vector<Value> args;
 	for_each (call->args().begin(), call->args().end(), [this, &args] (Expr* expr) {
 		args.push_back(this->evalExpr(expr));
+		_interpret->heap()->protect(args.back());
 	});
 
-	ValFn* val_callee = dynamic_cast<ValFn*>(callee);
-	return evalFnCall(val_callee->fn(), args);
+	// The function is resolved only when the callee differs from the last call of this site.
+	CallCache& cache = callCache(call);
+	if (cache.fn_id != callee.asFn()) {
+		fillCallCache(&cache, callee.asFn());
+	}
+
+	// A tail call is made by `evalFnCall` of the enclosing function.
+	if (call->tail()) {
+		_interpret->heap()->unprotect(args.size());
+		_tail_call = call->node_id().value();
+		_tail_args.swap(args);
+		return Value::Nil();
+	}
+
+	Value res = evalFnCall(cache, args);
+	_interpret->heap()->unprotect(args.size());
+	return res;
 }
 
 
 // TODO: Evaluates unary expression.
-Value* Evaluator::evalExprUnary(ExprUnary* unary) {
+Value Evaluator::evalExprUnary(ExprUnary* unary) {
 	FATAL("%s", "unimplemented: evalEmprMember");
 }
 
 
 // Evaluates binaray expression.
-Value* Evaluator::evalExprBinary(ExprBinary* binary) {
+Value Evaluator::evalExprBinary(ExprBinary* binary) {
 	// Operands
-	Value* operand1 = evalExpr(binary->left());
-	Value* operand2 = evalExpr(binary->right());
+	// The left operand is protected while the right one is evaluated.
+	Value operand1 = evalExpr(binary->left());
+	_interpret->heap()->protect(operand1);
+	Value operand2 = evalExpr(binary->right());
+	_interpret->heap()->unprotect(1);
 
 	// Operates and get the result.
-	Value* result =  Value::NoneVal();
+	Value result =  Value::NoneVal();
 	switch (binary->op()) {
-		case BO_ADD: result = operand1->add(operand2); break;
-		case BO_SUB: result = operand1->sub(operand2); break;
-		case BO_MUL: result = operand1->mul(operand2); break;
-		case BO_DIV: result = operand1->div(operand2); break;
-		case BO_EXP: result = operand1->exp(operand2); break;
-		case BO_EQ: result = operand1->eq(operand2); break;
-		case BO_NE: result = operand1->ne(operand2); break;
-		case BO_LT: result = operand1->lt(operand2); break;
-		case BO_LE: result = operand1->le(operand2); break;
-		case BO_GE: result = operand1->ge(operand2); break;
-		case BO_GT: result = operand1->gt(operand2); break;
+		case BO_ADD:
+			result = operand1.isHeap() ?
+				_interpret->heap()->concat(operand1, operand2) : operand1.add(operand2);
+			break;
+		case BO_SUB: result = operand1.sub(operand2); break;
+		case BO_MUL: result = operand1.mul(operand2); break;
+		case BO_DIV: result = operand1.div(operand2); break;
+		case BO_EXP: result = operand1.exp(operand2); break;
+		case BO_EQ: result = operand1.eq(operand2); break;
+		case BO_NE: result = operand1.ne(operand2); break;
+		case BO_LT: result = operand1.lt(operand2); break;
+		case BO_LE: result = operand1.le(operand2); break;
+		case BO_GE: result = operand1.ge(operand2); break;
+		case BO_GT: result = operand1.gt(operand2); break;
 	}
-	if (result == Value::NoneVal()) {
+	if (result.none()) {
 		FATAL("Unknown operation: %s %s %s",
-				operand1->toString().c_str(),
+				operand1.toString().c_str(),
 				AstStringify::toString(binary->op()).c_str(),
-				operand2->toString().c_str());
+				operand2.toString().c_str());
 	}
 
 	LOG(LOG_DEBUG, "binary operation %s = %s %s %s",
-			result->toString().c_str(),
-			operand1->toString().c_str(),
+			result.toString().c_str(),
+			operand1.toString().c_str(),
 			AstStringify::toString(binary->op()).c_str(),
-			operand2->toString().c_str());
+			operand2.toString().c_str());
 
 	// Push the result the stack
 	return result;
@@ -314,18 +370,18 @@ Value* Evaluator::evalExprBinary(ExprBinary* binary) {
 
 
 // TODO: Evaluates logical expression.
-Value* Evaluator::evalExprLogical(ExprLogical* logical) {
+Value Evaluator::evalExprLogical(ExprLogical* logical) {
 	FATAL("%s", "unimplemented: evalExprLogical");
 }
 
 
 // TODO: Evaluates conditional expression.
-Value* Evaluator::evalExprConditional(ExprConditional* conditional) {
+Value Evaluator::evalExprConditional(ExprConditional* conditional) {
 	FATAL("%s", "unimplemented: evalExprConditional");
 }
 
 
 // TODO: Evaluates assignment expression.
-Value* Evaluator::evalExprAssignment(ExprAssignment* assignment) {
+Value Evaluator::evalExprAssignment(ExprAssignment* assignment) {
 	FATAL("%s", "unimplemented: evalExprAssignment");
 }
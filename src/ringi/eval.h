@@ -14,7 +14,7 @@ namespace ringi {
 #include "../ringc/session/session.h"
 #include "values.h"
 #include "interpret.h"
-#include "environment.h"
+#include "frame.h"
 using namespace ring::ringc::ast;
 using namespace ring::ringc;
 using namespace ring::ringi;
@@ -31,39 +31,61 @@ public:
 
 	// Evaluate an AST.
 	// The given AST must be pre-resolved and related information should be stacked on the session.
-	Value* evaluate(AstNode* node);
+	Value evaluate(AstNode* node);
 
 protected:
 	Session* session();
-	Environment* currEnv();
-
-	void enterBlock(AstNode* node);
-	void exitBlock(AstNode* node);
-
-	Value* evalFnCall(NodeId fn_node_id, vector<Value*> args);
-	Value* evalFnCall(ExprFn* fn, vector<Value*> args);
-
-	Value* evalModule(Module* module);
-	Value* evalUse(Use* use);
-	Value* evalStmt(Stmt* stmt);
-	Value* evalLet(Let* let);
-	Value* evalExpr(Expr* expr);
-	Value* evalExprEmpty(ExprEmpty* empty);
-	Value* evalExprBlock(ExprBlock* block);
-	Value* evalExprFn(ExprFn* fn);
-	Value* evalExprIf(ExprIf* if_);
-	Value* evalExprIdent(ExprIdent* ident);
-	Value* evalExprLiteral(ExprLiteral* lit);
-	Value* evalExprMember(ExprMember* member);
-	Value* evalExprCall(ExprCall* call);
-	Value* evalExprUnary(ExprUnary* unary);
-	Value* evalExprBinary(ExprBinary* binary);
-	Value* evalExprLogical(ExprLogical* logical);
-	Value* evalExprConditional(ExprConditional* conditional);
-	Value* evalExprAssignment(ExprAssignment* assignment);
+
+	void enterFrame(AstNode* node);
+	void exitFrame(AstNode* node);
+
+	// What a call site called last time: the function and the frame slots of its arguments.
+	struct CallCache {
+		NodeId fn_id;
+		ExprFn* fn;
+		vector<int> arg_slots;
+	};
+
+	// Returns the cache of a call site.
+	CallCache& callCache(ExprCall* call);
+
+	// Resolves the function `fn_id` into `cache`. This is the slow path of a call.
+	void fillCallCache(CallCache* cache, NodeId fn_id);
+
+	Value evalFnCall(const CallCache& cache, const vector<Value>& args);
+
+	// Pushes the frame of a call and stores the arguments into it.
+	ExprFn* enterFnFrame(const CallCache& cache, const vector<Value>& args);
+
+	Value evalModule(Module* module);
+	Value evalUse(Use* use);
+	Value evalStmt(Stmt* stmt);
+	Value evalLet(Let* let);
+	Value evalExpr(Expr* expr);
+	Value evalExprEmpty(ExprEmpty* empty);
+	Value evalExprBlock(ExprBlock* block);
+	Value evalExprFn(ExprFn* fn);
+	Value evalExprIf(ExprIf* if_);
+	Value evalExprIdent(ExprIdent* ident);
+	Value evalExprLiteral(ExprLiteral* lit);
+	Value evalExprMember(ExprMember* member);
+	Value evalExprCall(ExprCall* call);
+	Value evalExprUnary(ExprUnary* unary);
+	Value evalExprBinary(ExprBinary* binary);
+	Value evalExprLogical(ExprLogical* logical);
+	Value evalExprConditional(ExprConditional* conditional);
+	Value evalExprAssignment(ExprAssignment* assignment);
 
 protected:
 	Interpret* _interpret;
+
+	// Indexed by the node id of the call.
+	vector<CallCache> _call_caches;
+
+	// Index in `_call_caches` of a call in tail position waiting for the frame of the current
+	// function, or -1. An index, since the caches move when a call site added by the REPL grows them.
+	int _tail_call;
+	vector<Value> _tail_args;
 };
 
 
@@ -0,0 +1,84 @@
+#include "frame.h"
+#include "../ringc/session/diagnostic.h"
+#include <algorithm>
+using namespace ring::ringi;
+
+
+FrameStack::FrameStack(Session* session)
+		: _session(session) {
+}
+
+
+// Pushes a frame of `size` slots for the function or module `node_id`.
+void FrameStack::push(NodeId node_id, int size) {
+	LOG(LOG_TRACE, "Push frame: %d, size %d", node_id, size);
+
+	Frame frame = { node_id, top(), size };
+	_frames.push_back(frame);
+	if (_slots.size() < frame.base + size) {
+		_slots.resize(frame.base + size);
+	}
+	fill(_slots.begin() + frame.base, _slots.begin() + frame.base + size,
+			Value::UninitailizedVal());
+}
+
+
+// Pops the top frame, which should belong to `node_id`.
+void FrameStack::pop(NodeId node_id) {
+	LOG(LOG_TRACE, "Pop frame: %d", node_id);
+
+	if (_frames.empty() || _frames.back().node_id != node_id) {
+		FATAL("Frame missmatch: exit from %d", node_id);
+	}
+	_frames.pop_back();
+}
+
+
+// Grows the top frame to `size` slots. New slots are uninitialized.
+void FrameStack::grow(int size) {
+	Frame& frame = _frames.back();
+	if (size <= frame.size) {
+		return;
+	}
+	if (_slots.size() < frame.base + size) {
+		_slots.resize(frame.base + size);
+	}
+	fill(_slots.begin() + frame.base + frame.size, _slots.begin() + frame.base + size,
+			Value::UninitailizedVal());
+	frame.size = size;
+}
+
+
+// Returns the slot of the nearest frame of `frame_id`, NULL if there is no such frame.
+// The current function and the module are the common cases, other frames are searched from the
+// top.
+Value* FrameStack::slot(NodeId frame_id, int slot) {
+	if (_frames.empty()) {
+		return NULL;
+	}
+	if (_frames.back().node_id == frame_id) {
+		return &_slots[_frames.back().base + slot];
+	}
+	if (_frames.front().node_id == frame_id) {
+		return &_slots[_frames.front().base + slot];
+	}
+	for (int i = _frames.size() - 2; i > 0; --i) {
+		if (_frames[i].node_id == frame_id) {
+			return &_slots[_frames[i].base + slot];
+		}
+	}
+	return NULL;
+}
+
+
+// Marks the slots of all frames.
+void FrameStack::markRoots(Heap* heap) {
+	for (int i = 0; i < top(); ++i) {
+		heap->mark(_slots[i]);
+	}
+}
+
+
+int FrameStack::top() const {
+	return _frames.empty() ? 0 : _frames.back().base + _frames.back().size;
+}
@@ -0,0 +1,71 @@
+#ifndef RING_RINGI_FRAME_H
+#define RING_RINGI_FRAME_H
+
+
+namespace ring {
+namespace ringi {
+	class FrameStack;
+}}
+
+
+#include "../common.h"
+#include "../ringc/session/session.h"
+#include "values.h"
+#include "heap.h"
+#include <vector>
+using namespace ring::ringc;
+using namespace std;
+
+
+namespace ring {
+namespace ringi {
+
+
+// FrameStack holds the runtime memory of symbols.
+// A frame is pushed when the evaluation enters a function or a module and holds all the symbols
+// of it at the slots given by the resolver, so blocks do not create frames. The slots of all
+// frames are laid out in one contiguous array which is reused by later calls.
+class FrameStack : public GcRoots {
+	ADD_PROPERTY_P(session, Session)
+
+public:
+	FrameStack(Session* session);
+
+	// Pushes a frame of `size` slots for the function or module `node_id`.
+	void push(NodeId node_id, int size);
+
+	// Pops the top frame, which should belong to `node_id`.
+	void pop(NodeId node_id);
+
+	// Grows the top frame to `size` slots. New slots are uninitialized.
+	void grow(int size);
+
+	// Returns the slot of the nearest frame of `frame_id`, NULL if there is no such frame.
+	Value* slot(NodeId frame_id, int slot);
+
+	// Returns a slot of the top frame.
+	Value* topSlot(int slot) { return &_slots[_frames.back().base + slot]; }
+
+	// Marks the slots of all frames.
+	void markRoots(Heap* heap);
+
+protected:
+	struct Frame {
+		NodeId node_id;
+		int base;
+		int size;
+	};
+
+	int top() const;
+
+protected:
+	vector<Value> _slots;
+	vector<Frame> _frames;
+};
+
+
+} // namespace ringi
+} // namespace ring
+
+
+#endif
@@ -0,0 +1,305 @@
+#include "heap.h"
+#include "../ringc/session/diagnostic.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+using namespace ring::ringi;
+using namespace std;
+
+
+#define ARENA_SIZE (256 * 1024)
+#define CELL_ALIGN 16
+#define LARGE_CELL_SIZE (8 * 1024)
+
+
+static size_t alignCell(size_t size) {
+	return (size + CELL_ALIGN - 1) & ~(size_t)(CELL_ALIGN - 1);
+}
+
+
+void GcStats::print(FILE* fd) const {
+	fprintf(fd, "gc: collections %lld, pause total %.3f ms, max %.3f ms\n",
+			(long long)collections, total_pause_ms, max_pause_ms);
+	fprintf(fd, "gc: allocated %lld objects (%lld bytes), freed %lld objects (%lld bytes)\n",
+			(long long)allocated_objects, (long long)allocated_bytes,
+			(long long)freed_objects, (long long)freed_bytes);
+	fprintf(fd, "gc: live %lld objects (%lld bytes), arenas %lld\n",
+			(long long)live_objects, (long long)live_bytes, (long long)arenas);
+}
+
+
+Heap::Heap(Session* session, int64_t threshold)
+		: _session(session)
+		, _curr_arena(-1)
+		, _free_lists(LARGE_CELL_SIZE / CELL_ALIGN + 1, NULL)
+		, _threshold(threshold)
+		, _next_gc(threshold)
+		, _heap_bytes(0) {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+
+Heap::~Heap() {
+	// Destroys all objects which are still alive.
+	for_each(_arenas.begin(), _arenas.end(), [](Arena& arena) {
+		for (char* p = arena.begin; p < arena.top; p += reinterpret_cast<Cell*>(p)->size) {
+			Cell* cell = reinterpret_cast<Cell*>(p);
+			if (!cell->free) {
+				objectOf(cell)->~HeapObject();
+			}
+		}
+		free(arena.begin);
+	});
+	for_each(_large_cells.begin(), _large_cells.end(), [](Cell* cell) {
+		objectOf(cell)->~HeapObject();
+		free(cell);
+	});
+}
+
+
+void Heap::addRoots(GcRoots* roots) {
+	_roots.push_back(roots);
+}
+
+
+void Heap::removeRoots(GcRoots* roots) {
+	_roots.erase(remove(_roots.begin(), _roots.end(), roots), _roots.end());
+}
+
+
+void Heap::protect(Value value) {
+	_protected.push_back(value);
+}
+
+
+void Heap::unprotect(int count) {
+	_protected.resize(_protected.size() - count);
+}
+
+
+void Heap::mark(Value value) {
+	if (value.isHeap()) {
+		markObject(value.asHeap());
+	}
+}
+
+
+void Heap::markObject(HeapObject* obj) {
+	Cell* cell = cellOf(obj);
+	if (!cell->marked) {
+		cell->marked = 1;
+		_mark_stack.push_back(obj);
+	}
+}
+
+
+// Runs a full collection.
+// Marks from the registered roots and the protected values, then sweeps all the cells.
+void Heap::collect() {
+	LOG(LOG_DEBUG, "GC start: heap %lld bytes", (long long)_heap_bytes);
+	auto start = chrono::steady_clock::now();
+
+	for_each(_roots.begin(), _roots.end(), [this](GcRoots* roots) {
+		roots->markRoots(this);
+	});
+	for_each(_protected.begin(), _protected.end(), [this](Value value) {
+		mark(value);
+	});
+	while (!_mark_stack.empty()) {
+		HeapObject* obj = _mark_stack.back();
+		_mark_stack.pop_back();
+		obj->trace(this);
+	}
+
+	sweep();
+	_next_gc = max(_threshold, _heap_bytes * 2);
+
+	double pause = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	_stats.collections++;
+	_stats.total_pause_ms += pause;
+	_stats.max_pause_ms = max(_stats.max_pause_ms, pause);
+	LOG(LOG_DEBUG, "GC end: heap %lld bytes, %.3f ms", (long long)_heap_bytes, pause);
+}
+
+
+void Heap::sweep() {
+	fill(_free_lists.begin(), _free_lists.end(), (FreeCell*)NULL);
+	_stats.live_objects = 0;
+	_stats.live_bytes = 0;
+
+	for_each(_arenas.begin(), _arenas.end(), [this](Arena& arena) {
+		sweepArena(arena);
+	});
+
+	vector<Cell*> large_cells;
+	for_each(_large_cells.begin(), _large_cells.end(), [this, &large_cells](Cell* cell) {
+		if (cell->marked) {
+			cell->marked = 0;
+			_stats.live_objects++;
+			_stats.live_bytes += cell->size;
+			large_cells.push_back(cell);
+		} else {
+			freeCell(cell);
+			free(cell);
+		}
+	});
+	_large_cells.swap(large_cells);
+
+	_heap_bytes = _stats.live_bytes;
+	_curr_arena = _arenas.empty() ? -1 : 0;
+}
+
+
+// Frees dead cells of an arena. An arena without live cells is reset to be bump allocated again,
+// otherwise its free cells go to the free lists.
+void Heap::sweepArena(Arena& arena) {
+	vector<Cell*> free_cells;
+	int live = 0;
+	for (char* p = arena.begin; p < arena.top; p += reinterpret_cast<Cell*>(p)->size) {
+		Cell* cell = reinterpret_cast<Cell*>(p);
+		if (cell->free) {
+			free_cells.push_back(cell);
+		} else if (cell->marked) {
+			cell->marked = 0;
+			live++;
+			_stats.live_bytes += cell->size;
+		} else {
+			freeCell(cell);
+			free_cells.push_back(cell);
+		}
+	}
+	_stats.live_objects += live;
+
+	if (live == 0) {
+		arena.top = arena.begin;
+		return;
+	}
+	for_each(free_cells.begin(), free_cells.end(), [this](Cell* cell) {
+		FreeCell* free_cell = reinterpret_cast<FreeCell*>(cell);
+		free_cell->next = _free_lists[cell->size / CELL_ALIGN];
+		_free_lists[cell->size / CELL_ALIGN] = free_cell;
+	});
+}
+
+
+void Heap::freeCell(Cell* cell) {
+	objectOf(cell)->~HeapObject();
+	cell->free = 1;
+	_stats.freed_objects++;
+	_stats.freed_bytes += cell->size;
+}
+
+
+// Returns zeroed memory for an object of `size` bytes.
+void* Heap::allocate(size_t size) {
+	size_t cell_size = alignCell(sizeof(Cell) + size);
+	if (_heap_bytes + cell_size > _next_gc) {
+		collect();
+	}
+
+	Cell* cell = NULL;
+	if (cell_size > LARGE_CELL_SIZE) {
+		cell = reinterpret_cast<Cell*>(malloc(cell_size));
+		if (cell != NULL) {
+			_large_cells.push_back(cell);
+		}
+	} else if (_free_lists[cell_size / CELL_ALIGN] != NULL) {
+		FreeCell* free_cell = _free_lists[cell_size / CELL_ALIGN];
+		_free_lists[cell_size / CELL_ALIGN] = free_cell->next;
+		cell = &free_cell->cell;
+	} else {
+		cell = reinterpret_cast<Cell*>(allocateInArena(cell_size));
+	}
+	if (cell == NULL) {
+		FATAL("Out of memory: allocating %d bytes", (int)size);
+	}
+
+	memset(cell, 0, cell_size);
+	cell->size = cell_size;
+
+	_heap_bytes += cell_size;
+	_stats.allocated_objects++;
+	_stats.allocated_bytes += cell_size;
+	return cell + 1;
+}
+
+
+// Bumps `cell_size` bytes from the current arena, moving to the next arena with enough room or
+// to a new arena.
+void* Heap::allocateInArena(size_t cell_size) {
+	for (; _curr_arena >= 0 && _curr_arena < _arenas.size(); ++_curr_arena) {
+		Arena& arena = _arenas[_curr_arena];
+		if (arena.top + cell_size <= arena.end) {
+			char* res = arena.top;
+			arena.top += cell_size;
+			return res;
+		}
+	}
+
+	char* mem = reinterpret_cast<char*>(malloc(ARENA_SIZE));
+	if (mem == NULL) {
+		return NULL;
+	}
+	Arena arena = { mem, mem + cell_size, mem + ARENA_SIZE };
+	_arenas.push_back(arena);
+	_curr_arena = _arenas.size() - 1;
+	_stats.arenas = _arenas.size();
+	return mem;
+}
+
+
+Value Heap::allocString(const char* chars, int length) {
+	void* mem = allocate(ValString::allocSize(length));
+	ValString* str = new (mem) ValString(length);
+	memcpy(str->chars(), chars, length);
+	str->chars()[length] = '\0';
+	return Value::Heap(str);
+}
+
+
+Value Heap::allocString(const string& str) {
+	return allocString(str.data(), str.size());
+}
+
+
+// Returns the value of a decoded literal. String literals are allocated.
+Value Heap::constValue(const Constant& constant) {
+	if (constant.type == CONST_STRING) {
+		return allocString(session()->str(constant.str_id).str());
+	}
+	return Value::Const(constant);
+}
+
+
+// Concatenates two strings.
+// The operands are protected since the allocation may collect.
+Value Heap::concat(Value left, Value right) {
+	if (left.value_type() != VALUE_STRING || right.value_type() != VALUE_STRING) {
+		FATAL("Operands of string concatenation should be strings: %s, %s",
+				left.toString().c_str(), right.toString().c_str());
+	}
+	protect(left);
+	protect(right);
+	ValString* lstr = static_cast<ValString*>(left.asHeap());
+	ValString* rstr = static_cast<ValString*>(right.asHeap());
+	int length = lstr->length() + rstr->length();
+	void* mem = allocate(ValString::allocSize(length));
+	ValString* str = new (mem) ValString(length);
+	memcpy(str->chars(), lstr->chars(), lstr->length());
+	memcpy(str->chars() + lstr->length(), rstr->chars(), rstr->length());
+	str->chars()[length] = '\0';
+	unprotect(2);
+	return Value::Heap(str);
+}
+
+
+Heap::Cell* Heap::cellOf(HeapObject* obj) {
+	return reinterpret_cast<Cell*>(obj) - 1;
+}
+
+
+HeapObject* Heap::objectOf(Cell* cell) {
+	return reinterpret_cast<HeapObject*>(cell + 1);
+}
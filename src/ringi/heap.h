@@ -0,0 +1,142 @@
+#ifndef RING_RINGI_HEAP_H
+#define RING_RINGI_HEAP_H
+
+
+namespace ring {
+namespace ringi {
+	class Heap;
+	class GcRoots;
+	struct GcStats;
+}}
+
+
+#include "../common.h"
+#include "../ringc/session/session.h"
+#include "values.h"
+#include <cstdio>
+#include <stdint.h>
+#include <vector>
+using namespace ring::ringc;
+using namespace std;
+
+
+namespace ring {
+namespace ringi {
+
+
+// Something that holds values which the collector should keep alive.
+class GcRoots {
+public:
+	virtual ~GcRoots() {}
+
+	// Marks every value held by this object with `Heap::mark`.
+	virtual void markRoots(Heap* heap) = 0;
+};
+
+
+struct GcStats {
+	int64_t collections;
+	int64_t allocated_objects;
+	int64_t allocated_bytes;
+	int64_t freed_objects;
+	int64_t freed_bytes;
+	int64_t live_objects;
+	int64_t live_bytes;
+	int64_t arenas;
+	double total_pause_ms;
+	double max_pause_ms;
+
+	void print(FILE* fd) const;
+};
+
+
+// Heap owns the boxed values of the interpreter and reclaims them with a precise mark-sweep
+// collector.
+// Objects are bump allocated in fixed size arenas, each preceded by a small cell header. A sweep
+// threads dead cells onto free lists by size and resets arenas that became empty. Large objects
+// are allocated one by one.
+// A collection starts on allocation once the heap grew beyond its threshold, so every value that
+// is alive at an allocation must be reachable from a registered GcRoots or be protected.
+class Heap {
+	ADD_PROPERTY_P(session, Session)
+	ADD_PROPERTY_R(stats, GcStats)
+
+public:
+	Heap(Session* session, int64_t threshold);
+	~Heap();
+
+	// Registers and unregisters a root set.
+	void addRoots(GcRoots* roots);
+	void removeRoots(GcRoots* roots);
+
+	// Keeps values alive which are held only by native variables, in LIFO order.
+	void protect(Value value);
+	void unprotect(int count);
+
+	// Marks a value and everything reachable from it.
+	void mark(Value value);
+
+	// Runs a full collection.
+	void collect();
+
+	Value allocString(const char* chars, int length);
+	Value allocString(const string& str);
+
+	// Returns the value of a decoded literal. String literals are allocated.
+	Value constValue(const Constant& constant);
+
+	// Concatenates two strings.
+	Value concat(Value left, Value right);
+
+protected:
+	struct Cell {
+		uint32_t size;
+		uint8_t marked;
+		uint8_t free;
+		uint16_t pad;
+	};
+
+	struct FreeCell {
+		Cell cell;
+		FreeCell* next;
+	};
+
+	struct Arena {
+		char* begin;
+		char* top;
+		char* end;
+	};
+
+	// Returns zeroed memory for an object of `size` bytes.
+	void* allocate(size_t size);
+	void* allocateInArena(size_t cell_size);
+
+	void markObject(HeapObject* obj);
+	void sweep();
+	void sweepArena(Arena& arena);
+	void freeCell(Cell* cell);
+
+	static Cell* cellOf(HeapObject* obj);
+	static HeapObject* objectOf(Cell* cell);
+
+protected:
+	vector<Arena> _arenas;
+	int _curr_arena;
+	vector<FreeCell*> _free_lists;
+	vector<Cell*> _large_cells;
+
+	vector<GcRoots*> _roots;
+	vector<Value> _protected;
+	vector<HeapObject*> _mark_stack;
+
+	int64_t _threshold;
+	int64_t _next_gc;
+	int64_t _heap_bytes;
+};
+
+
+} // namespace ringi
+} // namespace ring
+
+
+#endif
@@ -1,5 +1,8 @@
 #include "interpret.h"
 #include "eval.h"
+#include "compile.h"
+#include "jit.h"
+#include "vm.h"
 #include "../ringc/session/diagnostic.h"
 #include "../ringc/syntax/ast_printer.h"
 #include "../ringc/front/parser.h"
@@ -13,11 +16,20 @@ using namespace std;
 
 Interpret::Interpret(Session* session)
 		: _session(session)
-		, _env_base(new Environment(_session, NULL, NodeId()))
-		, _env_curr(_env_base)
+		, _heap(new Heap(session, session->config()->gc_threshold()))
 		, _eval(NULL)
+		, _frames(session)
 		, _repl_module(NULL)
 		, _repl_block(NULL) {
+	_heap->addRoots(&_frames);
+}
+
+
+Interpret::~Interpret() {
+	if (session()->config()->gc_stats()) {
+		_heap->stats().print(stderr);
+	}
+	delete _heap;
 }
 
 
@@ -62,18 +74,60 @@ bool Interpret::EvaluateProgram(Parser* parser) {
 	}
 
 	// Evaluates it.
-	Evaluator eval(this);
-	_eval = &eval;
-	Value* v = eval.evaluate(module);
+	Value v;
+	if (session()->config()->use_vm()) {
+		v = EvaluateModuleVM(module);
+	} else {
+		PhaseTimer timer(session(), "run");
+		Evaluator eval(this);
+		_eval = &eval;
+		v = eval.evaluate(module);
+	}
 
-	if (v) {
-		LOG(LOG_INFO, "program evaluates %s", v->toString().c_str());
+	if (v.valid() && !v.nil()) {
+		LOG(LOG_INFO, "program evaluates %s", v.toString().c_str());
 	}
 
 	return true;
 }
 
 
+// Compiles the module into bytecode and runs its `main` on the VM.
+Value Interpret::EvaluateModuleVM(Module* module) {
+	BytecodeModule bc_module;
+	heap()->addRoots(&bc_module);
+	Compiler compiler(session(), &bc_module, heap());
+	compiler.compile(module);
+
+	if (session()->config()->print_bytecode()) {
+		bc_module.print(stdout);
+	}
+
+	VM vm(session(), &bc_module, heap());
+	JIT jit(session(), &bc_module);
+	if (session()->config()->jit()) {
+		vm.jit(&jit);
+	}
+	PhaseTimer timer(session(), "run");
+	vm.initModule();
+
+	Value main = vm.global(MainName);
+	if (main.none()) {
+		FATAL("%s", "main function not found");
+	}
+	LOG(LOG_DEBUG, "invoke main function %d", session()->main());
+	Value res = vm.call(main, vector<Value>());
+
+	// The code as rewritten by the run, to see which instructions got quickened.
+	if (session()->config()->print_quickened()) {
+		bc_module.print(stdout);
+	}
+
+	heap()->removeRoots(&bc_module);
+	return res;
+}
+
+
 void Interpret::initREPL(Module* module, ExprBlock* block) {
 	_repl_module = module;
 	_repl_block = block;
@@ -105,14 +159,11 @@ bool Interpret::EvaluateExpression(const string& expr_str) {
 	}
 
 	// resolving
-	Resolver resolver(session());
-	resolver.resolveAst(stmt);
-
 	_repl_block->addStatement(stmt);
-	stmt->parent(_repl_block);
 
-	// Resolves names.
-	resolver.resolveSymbol(stmt);
+	// Resolves parents and names.
+	Resolver resolver(session());
+	resolver.resolveStmt(stmt, _repl_block);
 
 	if (session()->diagnostic()->mostSignificantLevel() <= REPORT_ERROR) {
 		return false;
@@ -123,117 +174,71 @@ bool Interpret::EvaluateExpression(const string& expr_str) {
 		astPrinter.print(stmt);
 	}
 
+	// The REPL frame gets slots for the new symbols.
+	_frames.grow(static_cast<ExprFn*>(_repl_block->parent())->frame_size());
+
 	// Evaluates it.
 	Evaluator eval(this);
 	_eval = &eval;
-	Value* v = eval.evaluate(stmt);
+	Value v = eval.evaluate(stmt);
 
-	if (v) {
-		printf("%s\n", v->toString().c_str());
+	if (!v.none()) {
+		printf("%s\n", v.toString().c_str());
 	}
 
-	env_curr()->clear();
-
 	return true;
 }
 
 
-// Enter into a block or scoping structure.
-// Entring a block incurs creation of new environment.
-void Interpret::enterBlock(NodeId node_id) {
-	LOG(LOG_TRACE, "Enter block: %d", node_id);
-
-	// Create new environment for the block.
-	Environment* new_env = new Environment(session(), env_curr(), node_id);
-
-	// Updates environment stack.
-	env_curr(new_env);
-
-	// Check `node_id` to see if there is real block in the AST.
-	if (node_id.none()) {
-		// if `node_id` is `NoneNode` that means the block is not a acually a AST node.
-		// It's a virtual block on interpreting environment.
+// Enter into a function or module.
+// The frame has a slot for every symbol defined in it.
+void Interpret::enterFrame(NodeId node_id) {
+	AstNode* node = session()->ast_table()->value(node_id);
+	if (node->isModule()) {
+		_frames.push(node_id, static_cast<Module*>(node)->frame_size());
+	} else if (node->isExprFn()) {
+		_frames.push(node_id, static_cast<ExprFn*>(node)->frame_size());
 	} else {
-		// There is a block node (scoping structure) in the AST.
-		// Find scope for this node.
-		ScopeId scope_id = session()->scope_node_map()->fromR(node_id);
-		if (scope_id.none()) {
-			FATAL("No scope for: block %d", node_id);
-		}
-		Scope* scope = session()->scope_table()->value(scope_id);
-		if (scope == NULL) {
-			FATAL("No scope for: block %d, scope %d", node_id, scope_id);
-		}
-		// Add symbols defined in this scope to environment.
-		vector<pair<SymbolId, NameId> > vec = scope->symbol_map().toListR();
-		for_each(vec.begin(), vec.end(), [this, new_env](pair<SymbolId, NameId> item) {
-			this->addSymbolEnv(new_env, item.first);
-		});
+		FATAL("No frame for: node %d", node_id);
 	}
 }
 
 
-// Exit from a block or scoping structure.
-void Interpret::exitBlock(NodeId node_id) {
-	LOG(LOG_TRACE, "Exit block: %d", node_id);
+// Enter into a function or module whose frame size is already known.
+void Interpret::enterFrame(NodeId node_id, int frame_size) {
+	_frames.push(node_id, frame_size);
+}
 
-	// The AST node connected to top environment shoud matched with the given node.
-	if (env_curr()->node_id() != node_id) {
-		FATAL("Environment missmatch: top is %d, but exit from %d", env_curr()->node_id(), node_id);
-	}
 
-	// Updates environment stack.
-	Environment* curr = env_curr();
-	env_curr(const_cast<Environment*>(curr->parent()));
-	delete curr;
+// Exit from a function or module.
+void Interpret::exitFrame(NodeId node_id) {
+	_frames.pop(node_id);
 }
 
 
 // Interprets a symbol initialized with `value`.
-void Interpret::initSymbol(SymbolId symbol_id, Value* value) {
-	LOG(LOG_TRACE, "Init symbol %d with value %s", symbol_id, value->toString().c_str());
-
-	if (_repl_module) {
-	}
-	else if (!env_curr()->contains(symbol_id)) {
-		// Invariant: current environment should contain the symbol uninitialized.
-		FATAL("No memory for symbol %d in the environment", symbol_id);
-	}
-
-	// Set value.
-	env_curr()->value(symbol_id, value);
+void Interpret::initSymbol(SymbolId symbol_id, Value value) {
+	LOG(LOG_TRACE, "Init symbol %d with value %s", symbol_id, value.toString().c_str());
+	*findSlot(symbol_id) = value;
 }
 
 
 // Get the value of a variable defined by `symbol_id` node.
-Value* Interpret::getValueFromEnv(SymbolId symbol_id) {
-	Environment* env = findEnvForSymbol(symbol_id);
-	if (env == NULL) {
-		FATAL("No memory for: symbol %d", symbol_id);
-	}
-	Value* value = env->value(symbol_id);
-	if (value == Value::NoneVal() ||
-			value == Value::UndefinedVal() ||
-			value == Value::UninitailizedVal()) {
-		FATAL("Uninitalized value for: symbol %d %p", symbol_id, value);
+Value Interpret::getSymbolValue(SymbolId symbol_id) {
+	Value value = *findSlot(symbol_id);
+	if (!value.valid()) {
+		FATAL("Uninitalized value for: symbol %d", symbol_id);
 	}
 	return value;
 }
 
 
-void Interpret::addSymbolEnv(Environment* env, SymbolId symbol_id) {
-	Symbol* symbol = session()->symbol_table()->value(symbol_id);
-	env->addSymbol(symbol_id, Value::UninitailizedVal());
-}
-
-
-// Finds environment where the given node is defined.
-// Returns NULL if there is no such environment.
-Environment* Interpret::findEnvForSymbol(SymbolId symbol_id) {
-	for (Environment* env = env_curr(); env != NULL; env = const_cast<Environment*>(env->parent())) {
-		if (env->contains(symbol_id)) {
-			return env;
-		}
+// Finds the slot of a symbol in the nearest frame of the function or module defining it.
+Value* Interpret::findSlot(SymbolId symbol_id) {
+	Symbol symbol = session()->symbol_table()->value(symbol_id);
+	Value* slot = _frames.slot(symbol.frame_id(), symbol.slot());
+	if (slot == NULL) {
+		FATAL("No memory for: symbol %d", symbol_id);
 	}
-	return NULL;
+	return slot;
 }
@@ -12,7 +12,8 @@ namespace ringi {
 #include "../ringc/session/session.h"
 #include "../ringc/front/parser.h"
 #include "../ringc/syntax/ast.h"
-#include "environment.h"
+#include "frame.h"
+#include "heap.h"
 #include "eval.h"
 using namespace ring::ringc;
 using namespace ring::ringc::ast;
@@ -24,11 +25,11 @@ namespace ringi {
 
 class Interpret {
 	ADD_PROPERTY_P(session, Session)
-	ADD_PROPERTY_P(env_base, Environment)
-	ADD_PROPERTY_P(env_curr, Environment)
+	ADD_PROPERTY_P(heap, Heap)
 
 public:
 	Interpret(Session* session);
+	~Interpret();
 
 	// Evaluates the given program.
 	bool EvaluateProgram(const string& program);
@@ -37,28 +38,33 @@ public:
 	// Evaluates the given expression.
 	bool EvaluateExpression(const string& expr);
 
-	// Enter into a block or scoping structure.
-	void enterBlock(NodeId node_id);
+	// Enter into a function or module.
+	void enterFrame(NodeId node_id);
+	void enterFrame(NodeId node_id, int frame_size);
 
-	// Exit from a block or scoping structure.
-	void exitBlock(NodeId node_id);
+	// Exit from a function or module.
+	void exitFrame(NodeId node_id);
 
 	// Interprets a symbol initialized with `value`.
-	void initSymbol(SymbolId symbol_id, Value* value);
+	void initSymbol(SymbolId symbol_id, Value value);
 
-	// Find the value of a symbol from environment.
-	Value* getValueFromEnv(SymbolId symbol_id);
+	// Initializes a slot of the current frame.
+	void initSlot(int slot, Value value) { *_frames.topSlot(slot) = value; }
+
+	// Find the value of a symbol from the frames.
+	Value getSymbolValue(SymbolId symbol_id);
 
 
 	void initREPL(Module* module, ExprBlock* block);
 
 protected:
 	bool EvaluateProgram(Parser* parser);
-	void addSymbolEnv(Environment* env, SymbolId symbol_id);
-	Environment* findEnvForSymbol(SymbolId symbol_id);
+	Value EvaluateModuleVM(Module* module);
+	Value* findSlot(SymbolId symbol_id);
 
 protected:
 	Evaluator* _eval;
+	FrameStack _frames;
 
 	Module* _repl_module;
 	ExprBlock* _repl_block;
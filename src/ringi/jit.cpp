@@ -0,0 +1,376 @@
+#include "jit.h"
+#include "../ringc/session/diagnostic.h"
+#include "../ringc/front/symbol.h"
+#include "../ringc/trans/trans_ir.h"
+#include <algorithm>
+#include <unistd.h>
+using namespace ring::ringi;
+using namespace ring::ringc;
+using namespace std;
+
+#include "llvm/Analysis/Verifier.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/TargetSelect.h"
+
+
+#define JIT_MAX_ARGS 4
+
+
+// Resolves the functions compiled before by name, and records the code sections of a module for
+// the perf map.
+class JitMemoryManager : public llvm::SectionMemoryManager {
+public:
+	JitMemoryManager(JIT* jit) : _jit(jit) {}
+
+	virtual uint64_t getSymbolAddress(const std::string& name) {
+		void* addr = _jit->symbolAddress(name);
+		if (addr != NULL) {
+			return (uint64_t)addr;
+		}
+		return llvm::SectionMemoryManager::getSymbolAddress(name);
+	}
+
+	virtual uint8_t* allocateCodeSection(
+			uintptr_t size, unsigned alignment, unsigned section_id, llvm::StringRef section_name) {
+		uint8_t* addr = llvm::SectionMemoryManager::allocateCodeSection(
+				size, alignment, section_id, section_name);
+		_code.push_back(make_pair(addr, size));
+		return addr;
+	}
+
+	const vector<pair<uint8_t*, uintptr_t> >& code() const { return _code; }
+
+protected:
+	JIT* _jit;
+	vector<pair<uint8_t*, uintptr_t> > _code;
+};
+
+
+JIT::JIT(Session* session, BytecodeModule* bc_module)
+		: _session(session)
+		, _bc_module(bc_module)
+		, _int_type_id(session->type_table()->getPrimTypeId(PRIM_TYPE_INT))
+		, _num_modules(0) {
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+}
+
+
+JIT::~JIT() {
+	for_each(_engines.begin(), _engines.end(), [](llvm::ExecutionEngine* engine) {
+		delete engine;
+	});
+	for_each(_jit_fns.begin(), _jit_fns.end(), [](pair<const NodeId, JitFn*>& entry) {
+		delete entry.second;
+	});
+}
+
+
+// Compiles a function and returns its native code.
+// The functions it calls are compiled together unless they have been compiled before.
+JitFn* JIT::compile(FnProto* proto) {
+	ScopeTracer tracer(session(), "JIT::compile()");
+	PhaseTimer timer(session(), "jit");
+
+	AstNode* node = session()->ast_table()->value(proto->node_id());
+	vector<ExprFn*> fns;
+	vector<Extern*> exts;
+	if (!node->isExprFn() || !collect(static_cast<ExprFn*>(node), &fns, &exts)) {
+		LOG(LOG_DEBUG, "JIT: function %s stays interpreted", proto->name().c_str());
+		proto->jit_failed(true);
+		return NULL;
+	}
+
+	// Translates the functions.
+	char module_name[32];
+	sprintf(module_name, "ring.jit.%d", _num_modules++);
+	llvm::Module* module = new llvm::Module(module_name, llvm::getGlobalContext());
+	TransIR trans_ir(session());
+	for_each(exts.begin(), exts.end(), [&trans_ir, module](Extern* ext) {
+		trans_ir.declareExtern(module, ext);
+	});
+	vector<pair<ExprFn*, llvm::Function*> > defs;
+	for_each(fns.begin(), fns.end(), [this, &trans_ir, module, &defs](ExprFn* fn) {
+		llvm::Function* ll_fn = trans_ir.declareFn(module, fn, fnName(fn));
+		if (_jit_fns.find(fn->node_id()) == _jit_fns.end()) {
+			defs.push_back(make_pair(fn, ll_fn));
+		}
+	});
+	for_each(defs.begin(), defs.end(), [&trans_ir](pair<ExprFn*, llvm::Function*>& def) {
+		trans_ir.defineFn(def.first, def.second);
+	});
+
+	// Loads the module.
+	string err;
+	llvm::ExecutionEngine* engine = NULL;
+	JitMemoryManager* memory = NULL;
+	if (!llvm::verifyModule(*module, llvm::ReturnStatusAction, &err)) {
+		memory = new JitMemoryManager(this);
+		engine = llvm::EngineBuilder(module)
+			.setErrorStr(&err)
+			.setEngineKind(llvm::EngineKind::JIT)
+			.setUseMCJIT(true)
+			.setMCJITMemoryManager(memory)
+			.create();
+	}
+	if (engine == NULL) {
+		LOG(LOG_INFO, "JIT: failed to compile %s: %s", proto->name().c_str(), err.c_str());
+		// The functions were translated once, they can not be translated again.
+		for_each(defs.begin(), defs.end(), [this](pair<ExprFn*, llvm::Function*>& def) {
+			_failed.insert(def.first->node_id());
+			FnProto* def_proto = bc_module()->fnProto(def.first->node_id());
+			if (def_proto != NULL) {
+				def_proto->jit_failed(true);
+			}
+		});
+		delete module;
+		return NULL;
+	}
+	engine->finalizeObject();
+	_engines.push_back(engine);
+
+	// Binds the native code to the functions.
+	vector<pair<void*, string> > syms;
+	for_each(defs.begin(), defs.end(), [this, engine, &syms](pair<ExprFn*, llvm::Function*>& def) {
+		ExprFn* fn = def.first;
+		void* addr = engine->getPointerToFunction(def.second);
+		string name = def.second->getName().str();
+		_symbols[name] = addr;
+		syms.push_back(make_pair(addr, name));
+
+		JitFn* jit_fn = new JitFn();
+		jit_fn->addr = addr;
+		jit_fn->num_args = fn->args().size();
+		jit_fn->ret_type = VALUE_INT;
+		_jit_fns[fn->node_id()] = jit_fn;
+		FnProto* fn_proto = bc_module()->fnProto(fn->node_id());
+		if (fn_proto != NULL) {
+			fn_proto->jit_fn(jit_fn);
+		}
+		LOG(LOG_DEBUG, "JIT: compiled %s at %p", name.c_str(), addr);
+	});
+
+	if (session()->config()->jit_perf_map()) {
+		writePerfMap(syms, memory->code());
+	}
+	return proto->jit_fn();
+}
+
+
+// Returns the address of a function compiled before, NULL if there is no such function.
+void* JIT::symbolAddress(const string& name) {
+	auto it = _symbols.find(name);
+	return it != _symbols.end() ? it->second : NULL;
+}
+
+
+// Collects `fn` and the functions and externs it calls.
+// Functions compiled before are collected to be declared, but not what they call.
+bool JIT::collect(ExprFn* fn, vector<ExprFn*>* fns, vector<Extern*>* exts) {
+	vector<ExprFn*> work(1, fn);
+	while (!work.empty()) {
+		ExprFn* curr = work.back();
+		work.pop_back();
+		if (find(fns->begin(), fns->end(), curr) != fns->end()) {
+			continue;
+		}
+		if (_failed.find(curr->node_id()) != _failed.end()) {
+			return false;
+		}
+		fns->push_back(curr);
+		if (_jit_fns.find(curr->node_id()) != _jit_fns.end()) {
+			continue;
+		}
+
+		vector<ExprFn*> callees;
+		if (!isIntFnType(curr->type_id()) ||
+				!checkStmts(curr->body()->stmts(), curr, &callees, exts)) {
+			return false;
+		}
+		work.insert(work.end(), callees.begin(), callees.end());
+	}
+	return true;
+}
+
+
+// Checks whether an expression can be compiled.
+// A test of an if expression should be a comparison, and comparisons are allowed only as tests,
+// since TransIR makes bools of comparisons only.
+bool JIT::checkExpr(
+		Expr* expr, ExprFn* fn, bool test, vector<ExprFn*>* callees, vector<Extern*>* exts) {
+	if (test && expr->node_type() != AST_EXPR_BINARY) {
+		return false;
+	}
+	switch (expr->node_type()) {
+		case AST_EXPR_LITERAL: {
+			ExprLiteral* lit = static_cast<ExprLiteral*>(expr);
+			if (lit->const_id().none()) {
+				return false;
+			}
+			const Constant& constant = session()->const_table()->value(lit->const_id());
+			return constant.type == CONST_INT && constant.bits <= 32;
+		}
+		case AST_EXPR_IDENT: {
+			// Only int locals of the function are read. Functions are only called.
+			ExprIdent* ident = static_cast<ExprIdent*>(expr);
+			Symbol symbol = session()->symbol_table()->value(ident->id().symbol_id());
+			return symbol.frame_id() == fn->node_id() && symbol.type_id() == _int_type_id;
+		}
+		case AST_EXPR_BINARY: {
+			ExprBinary* binary = static_cast<ExprBinary*>(expr);
+			bool cmp = false;
+			switch (binary->op()) {
+				case BO_ADD: case BO_SUB: case BO_MUL: case BO_DIV:
+					break;
+				case BO_EQ: case BO_NE: case BO_LT: case BO_LE: case BO_GE: case BO_GT:
+					cmp = true;
+					break;
+				default:
+					return false;
+			}
+			return cmp == test &&
+				checkExpr(binary->left(), fn, false, callees, exts) &&
+				checkExpr(binary->right(), fn, false, callees, exts);
+		}
+		case AST_EXPR_IF: {
+			// Both branches are needed for the value of the if.
+			ExprIf* if_ = static_cast<ExprIf*>(expr);
+			return if_->alt() != NULL && if_->type_id() == _int_type_id &&
+				checkExpr(if_->test(), fn, true, callees, exts) &&
+				checkExpr(if_->con(), fn, false, callees, exts) &&
+				checkExpr(if_->alt(), fn, false, callees, exts);
+		}
+		case AST_EXPR_BLOCK:
+			return checkStmts(static_cast<ExprBlock*>(expr)->stmts(), fn, callees, exts);
+		case AST_EXPR_CALL:
+			return checkCall(static_cast<ExprCall*>(expr), fn, callees, exts);
+		default:
+			return false;
+	}
+}
+
+
+// The last statement gives the value, so it should be an expression.
+bool JIT::checkStmts(
+		ArenaArray<Stmt*>& stmts, ExprFn* fn, vector<ExprFn*>* callees, vector<Extern*>* exts) {
+	if (stmts.empty() || !stmts.back()->isExpr()) {
+		return false;
+	}
+	for (int i = 0; i < stmts.size(); ++i) {
+		Expr* expr = NULL;
+		if (stmts[i]->isLet()) {
+			Let* let = static_cast<Let*>(stmts[i]);
+			Symbol symbol = session()->symbol_table()->value(let->name().symbol_id());
+			if (symbol.type_id() != _int_type_id) {
+				return false;
+			}
+			expr = let->expr();
+		} else {
+			expr = static_cast<Expr*>(stmts[i]);
+		}
+		if (!checkExpr(expr, fn, false, callees, exts)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Calls go to module level functions or to externs, statically bound by name.
+bool JIT::checkCall(ExprCall* call, ExprFn* fn, vector<ExprFn*>* callees, vector<Extern*>* exts) {
+	if (call->callee()->node_type() != AST_EXPR_IDENT) {
+		return false;
+	}
+	ExprIdent* ident = static_cast<ExprIdent*>(call->callee());
+	Symbol symbol = session()->symbol_table()->value(ident->id().symbol_id());
+	if (symbol.node_id().none() || !isIntFnType(symbol.type_id())) {
+		return false;
+	}
+	if (session()->type_table()->getFuncType(symbol.type_id())->args().size() !=
+			call->args().size()) {
+		return false;
+	}
+
+	AstNode* node = session()->ast_table()->value(symbol.node_id());
+	if (node->isExtern()) {
+		Extern* ext = static_cast<Extern*>(node);
+		if (find(exts->begin(), exts->end(), ext) == exts->end()) {
+			exts->push_back(ext);
+		}
+	} else if (node->isLet() && static_cast<Let*>(node)->inModuleScope() &&
+			static_cast<Let*>(node)->expr()->isExprFn()) {
+		callees->push_back(static_cast<ExprFn*>(static_cast<Let*>(node)->expr()));
+	} else {
+		return false;
+	}
+
+	for (int i = 0; i < call->args().size(); ++i) {
+		if (!checkExpr(call->args()[i], fn, false, callees, exts)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Native code takes and returns ints only.
+bool JIT::isIntFnType(TypeId type_id) {
+	if (!session()->type_table()->isFuncType(type_id)) {
+		return false;
+	}
+	FunctionType* fn_type = session()->type_table()->getFuncType(type_id);
+	if (fn_type->ret() != _int_type_id || fn_type->args().size() > JIT_MAX_ARGS) {
+		return false;
+	}
+	return all_of(fn_type->args().begin(), fn_type->args().end(), [this](TypeId arg) {
+		return arg == _int_type_id;
+	});
+}
+
+
+// Names are unique in the process, so modules refer to each other by name.
+string JIT::fnName(ExprFn* fn) {
+	string name = "fn";
+	if (fn->parent() && fn->parent()->isLet()) {
+		name = session()->str(static_cast<Let*>(fn->parent())->name().name_id()).str();
+	}
+	char suffix[16];
+	sprintf(suffix, ".%d", fn->node_id().value());
+	return "ring." + name + suffix;
+}
+
+
+// Appends the compiled functions to /tmp/perf-<pid>.map, which `perf` reads to symbolize JIT code.
+// A function is assumed to extend to the next function or to the end of its code section.
+void JIT::writePerfMap(const vector<pair<void*, string> >& syms,
+		const vector<pair<uint8_t*, uintptr_t> >& code) {
+	char path[64];
+	sprintf(path, "/tmp/perf-%d.map", (int)getpid());
+	FILE* fd = fopen(path, "a");
+	if (fd == NULL) {
+		LOG(LOG_INFO, "JIT: could not open perf map %s", path);
+		return;
+	}
+
+	vector<pair<void*, string> > sorted = syms;
+	sort(sorted.begin(), sorted.end());
+	for (int i = 0; i < sorted.size(); ++i) {
+		uint8_t* start = reinterpret_cast<uint8_t*>(sorted[i].first);
+		uint8_t* end = start;
+		for (int j = 0; j < code.size(); ++j) {
+			if (code[j].first <= start && start < code[j].first + code[j].second) {
+				end = code[j].first + code[j].second;
+			}
+		}
+		if (i + 1 < sorted.size()) {
+			end = min(end, reinterpret_cast<uint8_t*>(sorted[i + 1].first));
+		}
+		fprintf(fd, "%lx %lx %s\n",
+				(unsigned long)start, (unsigned long)(end - start), sorted[i].second.c_str());
+	}
+	fclose(fd);
+}
@@ -0,0 +1,96 @@
+#ifndef RING_RINGI_JIT_H
+#define RING_RINGI_JIT_H
+
+
+namespace ring {
+namespace ringi {
+	class JIT;
+	struct JitFn;
+}}
+
+
+#include "../common.h"
+#include "../ringc/session/session.h"
+#include "../ringc/syntax/ast.h"
+#include "bytecode.h"
+#include "values.h"
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+using namespace ring::ringc;
+using namespace ring::ringc::ast;
+using namespace std;
+
+
+namespace llvm {
+	class ExecutionEngine;
+}
+
+
+namespace ring {
+namespace ringi {
+
+
+// Native code of a function compiled by the JIT.
+// Arguments and the result are 32 bit ints.
+struct JitFn {
+	void* addr;
+	int num_args;
+	ValueType ret_type;
+};
+
+
+// JIT compiles hot functions into native code in process.
+// A function is translated by TransIR together with the functions it calls which are not compiled
+// yet, so native code calls native code. Functions compiled before are declared in the new module
+// and resolved by name when it is loaded. Only functions on ints, calling module level functions
+// or externs, are compiled; the others stay interpreted.
+class JIT {
+	ADD_PROPERTY_P(session, Session)
+	ADD_PROPERTY_P(bc_module, BytecodeModule)
+
+public:
+	JIT(Session* session, BytecodeModule* bc_module);
+	~JIT();
+
+	// Compiles a function and returns its native code.
+	// Returns NULL if it can not be compiled, and the function is never tried again.
+	JitFn* compile(FnProto* proto);
+
+	// Returns the address of a function compiled before, NULL if there is no such function.
+	void* symbolAddress(const string& name);
+
+protected:
+	// Collects `fn` and the functions and externs it calls.
+	// Returns false if any of them can not be compiled.
+	bool collect(ExprFn* fn, vector<ExprFn*>* fns, vector<Extern*>* exts);
+
+	// Checks whether an expression can be compiled. Comparisons are allowed only as tests.
+	bool checkExpr(Expr* expr, ExprFn* fn, bool test, vector<ExprFn*>* callees, vector<Extern*>* exts);
+	bool checkStmts(ArenaArray<Stmt*>& stmts, ExprFn* fn, vector<ExprFn*>* callees, vector<Extern*>* exts);
+	bool checkCall(ExprCall* call, ExprFn* fn, vector<ExprFn*>* callees, vector<Extern*>* exts);
+	bool isIntFnType(TypeId type_id);
+
+	string fnName(ExprFn* fn);
+
+	// Appends the compiled functions to the perf map of this process.
+	void writePerfMap(const vector<pair<void*, string> >& syms,
+			const vector<pair<uint8_t*, uintptr_t> >& code);
+
+protected:
+	vector<llvm::ExecutionEngine*> _engines;
+	map<string, void*> _symbols;
+	map<NodeId, JitFn*> _jit_fns;
+	set<NodeId> _failed; // Functions translated into a module which failed to load.
+	TypeId _int_type_id;
+	int _num_modules;
+};
+
+
+} // namespace ringi
+} // namespace ring
+
+
+#endif
@@ -1,276 +1,117 @@
 #include "values.h"
+#include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 using namespace ring::ringi;
 
 
-#define UNIMPLEMENTED(op) \
-	fprintf(stderr, "Unimplemented operateraion %s for value type %d\n", op, value_type());\
-	exit(EXIT_FAILURE);
-
-
-Value::Value(ValueType value_type)
-		: _value_type(value_type) {
-}
-
-
-Value* Value::NoneVal() {
-	return NULL;
-}
-
-
-Value* Value::UndefinedVal() {
-	return (Value*)-1;
-}
-
-
-Value* Value::UninitailizedVal() {
-	return (Value*)-2;
-}
-
-
-Value* Value::Nil() {
-	return (Value*)-3;
-}
-
-
-bool Value::none() {
-	return this == NoneVal();
-}
-
-
-bool Value::undefined() {
-	return this == UndefinedVal();
-}
-
-
-bool Value::uninitialized() {
-	return this == UninitailizedVal();
-}
-
-
-bool Value::nil() {
-	return this == Nil();
-}
-
-
-bool Value::valid() {
-	return !none() && !undefined() && !uninitialized();
-}
-
-
-Value* Value::add(const Value* other) const {
-	UNIMPLEMENTED("add");
-}
-
-
-Value* Value::sub(const Value* other) const {
-	UNIMPLEMENTED("sub");
-}
-
-
-Value* Value::mul(const Value* other) const {
-	UNIMPLEMENTED("mul");
-}
-
-
-Value* Value::div(const Value* other) const {
-	UNIMPLEMENTED("div");
-}
-
-
-Value* Value::exp(const Value* other) const {
-	UNIMPLEMENTED("exp");
-}
-
-
-ValBool* Value::eq(const Value* other) const {
-	UNIMPLEMENTED("eq");
-}
-
-
-ValBool* Value::ne(const Value* other) const {
-	UNIMPLEMENTED("ne");
-}
-
-
-ValBool* Value::lt(const Value* other) const {
-	UNIMPLEMENTED("lt");
-}
-
-
-ValBool* Value::le(const Value* other) const {
-	UNIMPLEMENTED("le");
-}
-
-
-ValBool* Value::ge(const Value* other) const {
-	UNIMPLEMENTED("ge");
-}
-
-
-ValBool* Value::gt(const Value* other) const {
-	UNIMPLEMENTED("gt");
-}
-
-
-ValFn::ValFn(NodeId fn)
-		: Value(VALUE_FN)
-		, _fn(fn) {
-}
-
-
-string ValFn::toString() const {
-	return "function";
-}
-
-
-ValNum::ValNum(ValueType value_type)
-		: Value(value_type) {
-}
-
-
-ValInt::ValInt(int v)
-		: ValNum(VALUE_INT)
-		, _value(v) {
-}
-
-
-ValInt::ValInt(const string& v)
-		: ValNum(VALUE_INT)
-		, _value(atoi(v.c_str())) {
+ValueType Value::value_type() const {
+	switch (tag()) {
+		case TAG_SPECIAL: return nil() ? VALUE_NIL : VALUE_INVALID;
+		case TAG_INT: return VALUE_INT;
+		case TAG_BOOL: return VALUE_BOOL;
+		case TAG_FN: return VALUE_FN;
+		case TAG_NATIVE_FN: return VALUE_NATIVE_FN;
+		case TAG_HEAP: return asHeap()->value_type();
+	}
+	return VALUE_INVALID;
 }
 
 
-string ValInt::toString() const {
+string Value::toString() const {
 	char buffer[20] = {0};
-	sprintf(buffer, "%d", value());
-	return buffer;
-}
-
-
-Value* ValInt::add(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return new ValInt(value() + iother->value());
-}
-
-
-Value* ValInt::sub(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return new ValInt(value() - iother->value());
-}
-
-
-Value* ValInt::mul(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return new ValInt(value() * iother->value());
-}
-
-
-Value* ValInt::div(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return new ValInt(value() / iother->value());
-}
-
-
-Value* ValInt::exp(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return new ValInt(pow(value(), iother->value()));
-}
-
-
-ValBool* ValInt::eq(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return value() == iother->value() ? ValBool::True() : ValBool::False();
-}
-
-
-ValBool* ValInt::ne(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return value() != iother->value() ? ValBool::True() : ValBool::False();
-}
-
-
-ValBool* ValInt::lt(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return value() < iother->value() ? ValBool::True() : ValBool::False();
-}
-
-
-ValBool* ValInt::le(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return value() <= iother->value() ? ValBool::True() : ValBool::False();
+	switch (tag()) {
+		case TAG_SPECIAL:
+			return nil() ? "nil" : "invalid";
+		case TAG_INT:
+			sprintf(buffer, "%d", asInt());
+			return buffer;
+		case TAG_BOOL:
+			return asBool() ? "true" : "false";
+		case TAG_FN:
+			return "function";
+		case TAG_NATIVE_FN:
+			return asNative()->toString();
+		case TAG_HEAP:
+			return asHeap()->toString();
+	}
+	return "invalid";
 }
 
 
-ValBool* ValInt::ge(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return value() >= iother->value() ? ValBool::True() : ValBool::False();
+// Returns the value of a decoded literal, none if it has no immediate value.
+Value Value::Const(const Constant& constant) {
+	switch (constant.type) {
+		case CONST_INT:
+			return constant.bits <= 32 ? Int(constant.int_value) : NoneVal();
+		case CONST_BOOL:
+			return Bool(constant.int_value != 0);
+		case CONST_STRING:
+			break;
+	}
+	return NoneVal();
 }
 
 
-ValBool* ValInt::gt(const Value* other) const {
-	const ValInt* iother = dynamic_cast<const ValInt*>(other);
-	return value() > iother->value() ? ValBool::True() : ValBool::False();
+Value Value::exp(Value other) const {
+	if (!bothInt(other)) {
+		return unimplemented("exp");
+	}
+	return Int(pow(asInt(), other.asInt()));
 }
 
 
-ValBool* ValBool::_true = NULL;
-ValBool* ValBool::_false = NULL;
-
-
-ValBool::ValBool(bool v)
-		: Value(VALUE_BOOL)
-		, _value(v) {
+// Compares boxed values, `expected` is the result when they are equal.
+Value Value::eqHeap(Value other, bool expected, const char* op) const {
+	if (value_type() != VALUE_STRING || other.value_type() != VALUE_STRING) {
+		return unimplemented(op);
+	}
+	const ValString* str = static_cast<const ValString*>(asHeap());
+	const ValString* ostr = static_cast<const ValString*>(other.asHeap());
+	bool equal = str->length() == ostr->length() &&
+		memcmp(str->chars(), ostr->chars(), str->length()) == 0;
+	return Bool(equal == expected);
 }
 
 
-ValBool::~ValBool() {
+Value Value::unimplemented(const char* op) const {
+	fprintf(stderr, "Unimplemented operateraion %s for value type %d\n", op, value_type());
+	exit(EXIT_FAILURE);
 }
 
 
-ValBool* ValBool::True() {
-	if (_true == NULL) {
-		_true = new ValBool(true);
-	}
-	return _true;
+NativeFn::NativeFn(const string& name, int num_args, void* addr)
+		: _name(name)
+		, _num_args(num_args)
+		, _addr(addr) {
 }
 
 
-ValBool* ValBool::False() {
-	if (_false == NULL) {
-		_false = new ValBool(false);
-	}
-	return _false;
+string NativeFn::toString() const {
+	return "native function " + name();
 }
 
 
-ValBool* ValBool::Bool(bool v) {
-	return v ? True() : False();
+HeapObject::HeapObject(ValueType value_type)
+		: _value_type(value_type) {
 }
 
 
-ValBool* ValBool::Bool(const string& v) {
-	return v == "true" ? True() : False();
+HeapObject::~HeapObject() {
 }
 
 
-string ValBool::toString() const {
-	if (value()) {
-		return "true";
-	} else {
-		return "false";
-	}
+void HeapObject::trace(Heap* heap) {
 }
 
 
-ValBool* ValBool::eq(const Value* other) const {
-	const ValBool* bother = dynamic_cast<const ValBool*>(other);
-	return value() == bother->value() ? ValBool::True() : ValBool::False();
+ValString::ValString(int length)
+		: HeapObject(VALUE_STRING)
+		, _length(length) {
 }
 
 
-ValBool* ValBool::ne(const Value* other) const {
-	const ValBool* bother = dynamic_cast<const ValBool*>(other);
-	return value() != bother->value() ? ValBool::True() : ValBool::False();
+string ValString::toString() const {
+	return string(chars(), length());
 }
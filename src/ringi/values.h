@@ -4,12 +4,17 @@
 
 namespace ring {
 namespace ringi {
-	class ValInt;
-	class ValBool;
+	class Value;
+	class NativeFn;
+	class HeapObject;
+	class ValString;
+	class Heap;
 }}
 
 
 #include "../common.h"
+#include "../ringc/session/const_table.h"
+#include <stdint.h>
 #include <string>
 using namespace ring::ringc;
 using namespace std;
@@ -21,109 +26,191 @@ namespace ringi {
 
 enum ValueType {
 	VALUE_INVALID,
+	VALUE_NIL,
 	VALUE_FN,
+	VALUE_NATIVE_FN,
 	VALUE_INT,
 	VALUE_BOOL,
+	VALUE_STRING,
 };
 
 
+// Value is a 64 bit tagged word passed by value.
+// The low 3 bits hold the tag. Ints, bools and references to functions are immediates, so
+// arithmetic and comparisons never allocate. Only aggregates are boxed as a HeapObject.
+//
+//   | payload (32)          | unused (29) | tag (3) |   int, bool, fn, special
+//   | pointer (61)                        | tag (3) |   native fn, heap
 class Value {
-	ADD_PROPERTY(value_type, ValueType)
-
 public:
-	Value(ValueType value_type);
+	enum Tag {
+		TAG_SPECIAL,
+		TAG_INT,
+		TAG_BOOL,
+		TAG_FN,
+		TAG_NATIVE_FN,
+		TAG_HEAP,
+	};
+
+	static const uint64_t TagBits = 3;
+	static const uint64_t TagMask = (1 << TagBits) - 1;
+
+	// A default value is `none`.
+	Value() : _bits(special(SPECIAL_NONE)) {}
+
+	static Value NoneVal() { return Value(special(SPECIAL_NONE)); }
+	static Value UndefinedVal() { return Value(special(SPECIAL_UNDEFINED)); }
+	static Value UninitailizedVal() { return Value(special(SPECIAL_UNINITIALIZED)); }
+	static Value Nil() { return Value(special(SPECIAL_NIL)); }
+
+	static Value Int(int v) { return Value(payload(v) | TAG_INT); }
+	static Value Bool(bool v) { return Value(payload(v) | TAG_BOOL); }
+	static Value Bool(const string& v) { return Bool(v == "true"); }
+	static Value Fn(NodeId fn) { return Value(payload(fn.value()) | TAG_FN); }
+	static Value Native(NativeFn* fn) { return Value((uint64_t)fn | TAG_NATIVE_FN); }
+	static Value Heap(HeapObject* obj) { return Value((uint64_t)obj | TAG_HEAP); }
+
+	// Returns the value of a decoded literal, none if it has no immediate value.
+	static Value Const(const Constant& constant);
+
+	Tag tag() const { return (Tag)(_bits & TagMask); }
+	uint64_t bits() const { return _bits; }
+	ValueType value_type() const;
+
+	bool none() const { return _bits == special(SPECIAL_NONE); }
+	bool undefined() const { return _bits == special(SPECIAL_UNDEFINED); }
+	bool uninitialized() const { return _bits == special(SPECIAL_UNINITIALIZED); }
+	bool nil() const { return _bits == special(SPECIAL_NIL); }
+	bool valid() const { return tag() != TAG_SPECIAL || nil(); }
+
+	bool isInt() const { return tag() == TAG_INT; }
+	bool isBool() const { return tag() == TAG_BOOL; }
+	bool isFn() const { return tag() == TAG_FN; }
+	bool isNative() const { return tag() == TAG_NATIVE_FN; }
+	bool isHeap() const { return tag() == TAG_HEAP; }
+
+	int asInt() const { return (int32_t)(_bits >> 32); }
+	bool asBool() const { return (_bits >> 32) != 0; }
+	NodeId asFn() const { return NodeId((int32_t)(_bits >> 32)); }
+	NativeFn* asNative() const { return (NativeFn*)(_bits & ~TagMask); }
+	HeapObject* asHeap() const { return (HeapObject*)(_bits & ~TagMask); }
+
+	// Identity of two values.
+	bool operator ==(const Value& other) const { return _bits == other._bits; }
+	bool operator !=(const Value& other) const { return _bits != other._bits; }
 
-	static Value* NoneVal();
-	static Value* UndefinedVal();
-	static Value* UninitailizedVal();
-	static Value* Nil();
+	string toString() const;
 
-	bool none();
-	bool undefined();
-	bool uninitialized();
-	bool valid();
-	bool nil();
+	Value add(Value other) const {
+		return bothInt(other) ? Int(asInt() + other.asInt()) : unimplemented("add");
+	}
+	Value sub(Value other) const {
+		return bothInt(other) ? Int(asInt() - other.asInt()) : unimplemented("sub");
+	}
+	Value mul(Value other) const {
+		return bothInt(other) ? Int(asInt() * other.asInt()) : unimplemented("mul");
+	}
+	Value div(Value other) const {
+		return bothInt(other) ? Int(asInt() / other.asInt()) : unimplemented("div");
+	}
+	Value exp(Value other) const;
+
+	// Ints and bools compare equal when their words are equal.
+	Value eq(Value other) const {
+		return sameScalar(other) ? Bool(_bits == other._bits) : eqHeap(other, true, "eq");
+	}
+	Value ne(Value other) const {
+		return sameScalar(other) ? Bool(_bits != other._bits) : eqHeap(other, false, "ne");
+	}
+	Value lt(Value other) const {
+		return bothInt(other) ? Bool(asInt() < other.asInt()) : unimplemented("lt");
+	}
+	Value le(Value other) const {
+		return bothInt(other) ? Bool(asInt() <= other.asInt()) : unimplemented("le");
+	}
+	Value ge(Value other) const {
+		return bothInt(other) ? Bool(asInt() >= other.asInt()) : unimplemented("ge");
+	}
+	Value gt(Value other) const {
+		return bothInt(other) ? Bool(asInt() > other.asInt()) : unimplemented("gt");
+	}
 
-	virtual string toString() const = 0;
+protected:
+	enum Special {
+		SPECIAL_NONE,
+		SPECIAL_UNDEFINED,
+		SPECIAL_UNINITIALIZED,
+		SPECIAL_NIL,
+	};
 
-	virtual Value* add(const Value* other) const;
-	virtual Value* sub(const Value* other) const;
-	virtual Value* mul(const Value* other) const;
-	virtual Value* div(const Value* other) const;
-	virtual Value* exp(const Value* other) const;
-
-	virtual ValBool* eq(const Value* other) const;
-	virtual ValBool* ne(const Value* other) const;
-	virtual ValBool* lt(const Value* other) const;
-	virtual ValBool* le(const Value* other) const;
-	virtual ValBool* ge(const Value* other) const;
-	virtual ValBool* gt(const Value* other) const;
-};
+	explicit Value(uint64_t bits) : _bits(bits) {}
 
+	static uint64_t special(Special s) { return ((uint64_t)s << 32) | TAG_SPECIAL; }
+	static uint64_t payload(int v) { return (uint64_t)(uint32_t)v << 32; }
 
-class ValFn : public Value {
-	ADD_PROPERTY(fn, NodeId)
+	bool bothInt(Value other) const { return tag() == TAG_INT && other.tag() == TAG_INT; }
+	bool sameScalar(Value other) const {
+		return tag() == other.tag() && (tag() == TAG_INT || tag() == TAG_BOOL);
+	}
 
-public:
-	ValFn(NodeId fn);
+	// Compares boxed values, `expected` is the result when they are equal.
+	Value eqHeap(Value other, bool expected, const char* op) const;
 
-	string toString() const;
+	// Reports an operation on unsupported operand types and exits.
+	Value unimplemented(const char* op) const;
+
+protected:
+	uint64_t _bits;
 };
 
 
-class ValNum : public Value {
+// A function provided by the host process, bound to an `extern` declaration.
+// It is referenced by `Value::Native` and owned by whoever binds the extern.
+class NativeFn {
+	ADD_PROPERTY(name, string)
+	ADD_PROPERTY(num_args, int)
+	ADD_PROPERTY_P(addr, void)
+
 public:
-	ValNum(ValueType value_type);
+	NativeFn(const string& name, int num_args, void* addr);
+
+	string toString() const;
 };
 
 
-class ValInt: public ValNum {
-	ADD_PROPERTY(value, int)
+// Base of boxed values. Only aggregate values live on the heap.
+// Boxes are allocated and reclaimed by the Heap.
+class HeapObject {
+	ADD_PROPERTY(value_type, ValueType)
 
 public:
-	ValInt(int v);
-	ValInt(const string& v);
+	HeapObject(ValueType value_type);
+	virtual ~HeapObject();
 
-	string toString() const;
+	virtual string toString() const = 0;
 
-	Value* add(const Value* other) const;
-	Value* sub(const Value* other) const;
-	Value* mul(const Value* other) const;
-	Value* div(const Value* other) const;
-	Value* exp(const Value* other) const;
-
-	ValBool* eq(const Value* other) const;
-	ValBool* ne(const Value* other) const;
-	ValBool* lt(const Value* other) const;
-	ValBool* le(const Value* other) const;
-	ValBool* ge(const Value* other) const;
-	ValBool* gt(const Value* other) const;
+	// Marks the values referenced by this object.
+	virtual void trace(Heap* heap);
 };
 
 
-class ValBool : public Value {
-	ADD_PROPERTY(value, bool)
+// An immutable string. The characters follow the object in the same heap cell.
+class ValString : public HeapObject {
+	ADD_PROPERTY(length, int)
 
 public:
-	static ValBool* True();
-	static ValBool* False();
-	static ValBool* Bool(bool v);
-	static ValBool* Bool(const string& v);
+	ValString(int length);
 
-	string toString() const;
+	char* chars() { return reinterpret_cast<char*>(this + 1); }
+	const char* chars() const { return reinterpret_cast<const char*>(this + 1); }
 
-	ValBool* eq(const Value* other) const;
-	ValBool* ne(const Value* other) const;
+	string toString() const;
 
-protected:
-	ValBool(bool v);
-	~ValBool();
-	static ValBool* _true;
-	static ValBool* _false;
+	// Returns the number of bytes for a string of `length` characters.
+	static size_t allocSize(int length) { return sizeof(ValString) + length + 1; }
 };
 
 
-
 } // namespace ringi
 } // namespace ring
 
@@ -0,0 +1,548 @@
+#include "vm.h"
+#include "../ringc/session/diagnostic.h"
+#include <algorithm>
+using namespace ring::ringi;
+using namespace ring::ringc;
+using namespace std;
+
+
+// Threaded dispatch through a table of label addresses is used where the compiler supports it,
+// otherwise the dispatch loop falls back to a switch.
+#if defined(__GNUC__) && !defined(RING_NO_COMPUTED_GOTO)
+#define RING_COMPUTED_GOTO
+#endif
+
+#define STACK_INIT_SIZE 1024
+
+#define OPERAND_A() InstrUtil::a(i)
+#define OPERAND_B() InstrUtil::b(i)
+#define OPERAND_C() InstrUtil::c(i)
+#define OPERAND_BX() InstrUtil::bx(i)
+#define OPERAND_SBX() InstrUtil::sbx(i)
+
+#define LOAD_FRAME() \
+	do {\
+		frame = &_frames.back();\
+		pc = frame->pc;\
+		R = &_stack[frame->base];\
+		K = frame->proto->consts().data();\
+	} while (0)
+
+#ifdef RING_COMPUTED_GOTO
+#define OP_LABEL(op) &&L_##op,
+#define CASE(op) L_##op:
+#define DISPATCH() do { i = *pc++; goto *labels[InstrUtil::op(i)]; } while (0)
+#else
+#define CASE(op) case op:
+#define DISPATCH() continue
+#endif
+
+#define BINARY_OP(op, fn) \
+	CASE(op) {\
+		R[OPERAND_A()] = R[OPERAND_B()].fn(R[OPERAND_C()]);\
+		DISPATCH();\
+	}
+
+#define BINARY_OPK(op, fn) \
+	CASE(op) {\
+		R[OPERAND_A()] = R[OPERAND_B()].fn(K[OPERAND_C()]);\
+		DISPATCH();\
+	}
+
+// A generic arithmetic op rewrites itself into `quick_op` once it sees two ints.
+#define QUICKENING_OP(op, fn, quick_op) \
+	CASE(op) {\
+		Value left = R[OPERAND_B()];\
+		Value right = R[OPERAND_C()];\
+		if (left.isInt() && right.isInt()) {\
+			pc[-1] = InstrUtil::patchOp(i, quick_op);\
+		}\
+		R[OPERAND_A()] = left.fn(right);\
+		DISPATCH();\
+	}
+
+// A quickened op runs on ints only. Otherwise it goes back to the generic op and runs it again.
+#define QUICK_INT_OP(op, c_op, generic_op) \
+	CASE(op) {\
+		Value left = R[OPERAND_B()];\
+		Value right = R[OPERAND_C()];\
+		if (left.isInt() && right.isInt()) {\
+			R[OPERAND_A()] = Value::Int(left.asInt() c_op right.asInt());\
+			DISPATCH();\
+		}\
+		pc[-1] = InstrUtil::patchOp(i, generic_op);\
+		pc--;\
+		DISPATCH();\
+	}
+
+// A fused branch falls through to its JMP when the test fails and skips it otherwise.
+#define BRANCH_IF(cond) \
+	do {\
+		if (cond) {\
+			pc++;\
+		} else {\
+			pc += 1 + InstrUtil::sbx(*pc);\
+		}\
+	} while (0)
+
+
+static bool isTrue(Value value) {
+	if (!value.isBool()) {
+		fprintf(stderr, "Condition expected to be bool type\n");
+		exit(EXIT_FAILURE);
+	}
+	return value.asBool();
+}
+
+
+// Compares two values for a fused branch. Ints are compared in place.
+static inline bool compare(int kind, Value left, Value right) {
+	if (left.isInt() && right.isInt()) {
+		int l = left.asInt();
+		int r = right.asInt();
+		switch (kind) {
+			case CMP_EQ: return l == r;
+			case CMP_NE: return l != r;
+			case CMP_LT: return l < r;
+			case CMP_LE: return l <= r;
+			case CMP_GE: return l >= r;
+			case CMP_GT: return l > r;
+		}
+	}
+	switch (kind) {
+		case CMP_EQ: return isTrue(left.eq(right));
+		case CMP_NE: return isTrue(left.ne(right));
+		case CMP_LT: return isTrue(left.lt(right));
+		case CMP_LE: return isTrue(left.le(right));
+		case CMP_GE: return isTrue(left.ge(right));
+		case CMP_GT: return isTrue(left.gt(right));
+	}
+	fprintf(stderr, "Unknown comparison %d\n", kind);
+	exit(EXIT_FAILURE);
+}
+
+
+VM::VM(Session* session, BytecodeModule* bc_module, Heap* heap)
+		: _session(session)
+		, _bc_module(bc_module)
+		, _heap(heap)
+		, _jit(NULL)
+		, _stack(STACK_INIT_SIZE, Value::UninitailizedVal()) {
+	_heap->addRoots(this);
+}
+
+
+VM::~VM() {
+	_heap->removeRoots(this);
+}
+
+
+void VM::initModule() {
+	ScopeTracer tracer(session(), "VM::initModule()");
+
+	_globals.assign(bc_module()->numGlobals(), Value::UninitailizedVal());
+	int depth = _frames.size();
+	pushFrame(bc_module()->init(), stackTop());
+	run(depth);
+}
+
+
+Value VM::call(Value fn, const vector<Value>& args) {
+	if (!fn.isFn()) {
+		FATAL("%s", "Callee expected to be function type");
+	}
+	FnProto* proto = bc_module()->fnProto(fn.asFn());
+	if (proto == NULL) {
+		FATAL("No code for function: node %d", fn.asFn());
+	}
+	if (proto->num_args() != args.size()) {
+		FATAL("Function %s takes %d arguments, but %d given",
+				proto->name().c_str(), proto->num_args(), (int)args.size());
+	}
+
+	// The callee and the arguments are laid out the same way a CALL instruction does.
+	int top = stackTop();
+	ensureStack(top, args.size() + 1);
+	_stack[top] = fn;
+	copy(args.begin(), args.end(), _stack.begin() + top + 1);
+
+	int depth = _frames.size();
+	pushFrame(proto, top + 1);
+	return run(depth);
+}
+
+
+Value VM::global(const string& name) {
+	const vector<string>& names = bc_module()->global_names();
+	for (int i = 0; i < names.size(); ++i) {
+		if (names[i] == name) {
+			return _globals[i];
+		}
+	}
+	return Value::NoneVal();
+}
+
+
+// Marks the registers of all frames and the globals.
+void VM::markRoots(Heap* heap) {
+	for (int i = 0; i < stackTop(); ++i) {
+		heap->mark(_stack[i]);
+	}
+	for_each(_globals.begin(), _globals.end(), [heap](Value value) {
+		heap->mark(value);
+	});
+}
+
+
+int VM::stackTop() const {
+	return _frames.empty() ? 0 : _frames.back().base + _frames.back().proto->num_regs();
+}
+
+
+// Returns the checked code of a ring function called with `num_args` arguments.
+// This is the slow path of a call.
+FnProto* VM::calleeProto(Value callee, int num_args) {
+	FnProto* proto = bc_module()->fnProto(callee.asFn());
+	if (proto == NULL || proto->num_args() != num_args) {
+		FATAL("Invalid call to function: node %d", callee.asFn());
+	}
+	return proto;
+}
+
+
+// Returns the checked code of a ring function through the inline cache `c` of `caller`.
+// The arity is checked only when the cache is filled.
+inline FnProto* VM::cachedProto(FnProto* caller, int c, Value callee, int num_args) {
+	if (c == FnProto::NoCallCache) {
+		return calleeProto(callee, num_args);
+	}
+	CallCache& cache = caller->call_caches()[c];
+	if (cache.callee != callee) {
+		cache.proto = calleeProto(callee, num_args);
+		cache.callee = callee;
+	}
+	return cache.proto;
+}
+
+
+// Registers above the arguments are cleared, so the collector never sees what an earlier frame
+// left there.
+void VM::pushFrame(FnProto* proto, int base) {
+	ensureStack(base, proto->num_regs());
+	fill(_stack.begin() + base + proto->num_args(), _stack.begin() + base + proto->num_regs(),
+			Value::Nil());
+	CallFrame frame = { proto, proto->code().data(), base };
+	_frames.push_back(frame);
+}
+
+
+// Pops the top frame and passes `res` to the caller.
+// The result replaces the callee in the caller frame. The registers of the callee that lie in the
+// window of the caller are cleared; the collector marks that window, and would otherwise keep what
+// they hold alive until the caller writes over them.
+bool VM::popFrame(Value res, int stop_depth) {
+	int base = _frames.back().base;
+	int end = base + _frames.back().proto->num_regs();
+	_frames.pop_back();
+	end = min(end, stackTop());
+	if (base < end) {
+		fill(_stack.begin() + base, _stack.begin() + end, Value::Nil());
+	}
+	if (_frames.size() == stop_depth) {
+		return true;
+	}
+	_stack[base - 1] = res;
+	return false;
+}
+
+
+void VM::ensureStack(int base, int size) {
+	if (base + size > _stack.size()) {
+		_stack.resize(max<size_t>(_stack.size() * 2, base + size), Value::UninitailizedVal());
+	}
+}
+
+
+// Counts a call of `proto` and compiles it once it gets hot.
+// Back edges are counted by the jumps, but a running frame stays in the interpreter until the
+// function is called again.
+inline JitFn* VM::tierUp(FnProto* proto) {
+	if (proto->jit_fn() != NULL || jit() == NULL || proto->jit_failed()) {
+		return proto->jit_fn();
+	}
+	proto->hotness(proto->hotness() + 1);
+	if (proto->hotness() < session()->config()->jit_threshold()) {
+		return NULL;
+	}
+	return jit()->compile(proto);
+}
+
+
+Value VM::callNative(NativeFn* fn, Value* args, int num_args) {
+	if (fn->addr() == NULL) {
+		FATAL("No native function for: extern %s", fn->name().c_str());
+	}
+	if (fn->num_args() != num_args) {
+		FATAL("Function %s takes %d arguments, but %d given",
+				fn->name().c_str(), fn->num_args(), num_args);
+	}
+	return Value::Int(callInts(fn->addr(), fn->name(), args, num_args));
+}
+
+
+// The arity was checked when the callee was cached.
+Value VM::callJit(JitFn* fn, Value* args, int num_args) {
+	int res = callInts(fn->addr, "jit function", args, num_args);
+	return fn->ret_type == VALUE_BOOL ? Value::Bool(res != 0) : Value::Int(res);
+}
+
+
+int VM::callInts(void* addr, const string& name, Value* args, int num_args) {
+	int iargs[4];
+	for (int ix = 0; ix < num_args && ix < 4; ++ix) {
+		Value arg = args[ix];
+		if (arg.isInt()) {
+			iargs[ix] = arg.asInt();
+		} else if (arg.isBool()) {
+			iargs[ix] = arg.asBool();
+		} else {
+			FATAL("Native function %s takes only int or bool arguments", name.c_str());
+		}
+	}
+
+	switch (num_args) {
+		case 0: return ((int (*)())addr)();
+		case 1: return ((int (*)(int))addr)(iargs[0]);
+		case 2: return ((int (*)(int, int))addr)(iargs[0], iargs[1]);
+		case 3: return ((int (*)(int, int, int))addr)(iargs[0], iargs[1], iargs[2]);
+		case 4: return ((int (*)(int, int, int, int))addr)(iargs[0], iargs[1], iargs[2], iargs[3]);
+		default:
+			FATAL("Too many arguments for native function %s", name.c_str());
+	}
+	return 0;
+}
+
+
+// The dispatch loop.
+Value VM::run(int stop_depth) {
+	CallFrame* frame;
+	Instr* pc;
+	Value* R;
+	const Value* K;
+	Instr i;
+
+	LOAD_FRAME();
+
+#ifdef RING_COMPUTED_GOTO
+	static void* labels[] = {
+		OP_LABEL(OP_NOP)
+		OP_LABEL(OP_MOVE)
+		OP_LABEL(OP_LOADK)
+		OP_LABEL(OP_LOADNIL)
+		OP_LABEL(OP_GETGLOBAL)
+		OP_LABEL(OP_SETGLOBAL)
+		OP_LABEL(OP_ADD)
+		OP_LABEL(OP_SUB)
+		OP_LABEL(OP_MUL)
+		OP_LABEL(OP_DIV)
+		OP_LABEL(OP_EXP)
+		OP_LABEL(OP_EQ)
+		OP_LABEL(OP_NE)
+		OP_LABEL(OP_LT)
+		OP_LABEL(OP_LE)
+		OP_LABEL(OP_GE)
+		OP_LABEL(OP_GT)
+		OP_LABEL(OP_JMP)
+		OP_LABEL(OP_JMPT)
+		OP_LABEL(OP_JMPF)
+		OP_LABEL(OP_CALL)
+		OP_LABEL(OP_TAILCALL)
+		OP_LABEL(OP_RET)
+		OP_LABEL(OP_ADDK)
+		OP_LABEL(OP_SUBK)
+		OP_LABEL(OP_JCMP)
+		OP_LABEL(OP_JCMPK)
+		OP_LABEL(OP_ADD_II)
+		OP_LABEL(OP_SUB_II)
+		OP_LABEL(OP_MUL_II)
+	};
+	DISPATCH();
+#else
+	while (true) {
+		i = *pc++;
+		switch (InstrUtil::op(i)) {
+#endif
+
+		CASE(OP_NOP) {
+			DISPATCH();
+		}
+
+		CASE(OP_MOVE) {
+			R[OPERAND_A()] = R[OPERAND_B()];
+			DISPATCH();
+		}
+
+		CASE(OP_LOADK) {
+			R[OPERAND_A()] = K[OPERAND_BX()];
+			DISPATCH();
+		}
+
+		CASE(OP_LOADNIL) {
+			R[OPERAND_A()] = Value::Nil();
+			DISPATCH();
+		}
+
+		CASE(OP_GETGLOBAL) {
+			Value value = _globals[OPERAND_BX()];
+			if (value.uninitialized()) {
+				FATAL("Uninitalized value for: global %s",
+						bc_module()->global_names()[OPERAND_BX()].c_str());
+			}
+			R[OPERAND_A()] = value;
+			DISPATCH();
+		}
+
+		CASE(OP_SETGLOBAL) {
+			_globals[OPERAND_BX()] = R[OPERAND_A()];
+			DISPATCH();
+		}
+
+		CASE(OP_ADD) {
+			Value left = R[OPERAND_B()];
+			Value right = R[OPERAND_C()];
+			if (left.isHeap()) {
+				R[OPERAND_A()] = heap()->concat(left, right);
+			} else {
+				if (left.isInt() && right.isInt()) {
+					pc[-1] = InstrUtil::patchOp(i, OP_ADD_II);
+				}
+				R[OPERAND_A()] = left.add(right);
+			}
+			DISPATCH();
+		}
+
+		QUICKENING_OP(OP_SUB, sub, OP_SUB_II)
+		QUICKENING_OP(OP_MUL, mul, OP_MUL_II)
+		BINARY_OP(OP_DIV, div)
+		BINARY_OP(OP_EXP, exp)
+		BINARY_OP(OP_EQ, eq)
+		BINARY_OP(OP_NE, ne)
+		BINARY_OP(OP_LT, lt)
+		BINARY_OP(OP_LE, le)
+		BINARY_OP(OP_GE, ge)
+		BINARY_OP(OP_GT, gt)
+
+		CASE(OP_JMP) {
+			if (OPERAND_SBX() < 0 && jit() != NULL) {
+				frame->proto->hotness(frame->proto->hotness() + 1);
+			}
+			pc += OPERAND_SBX();
+			DISPATCH();
+		}
+
+		CASE(OP_JMPT) {
+			if (isTrue(R[OPERAND_A()])) {
+				pc += OPERAND_SBX();
+			}
+			DISPATCH();
+		}
+
+		CASE(OP_JMPF) {
+			if (!isTrue(R[OPERAND_A()])) {
+				pc += OPERAND_SBX();
+			}
+			DISPATCH();
+		}
+
+		CASE(OP_CALL) {
+			int a = OPERAND_A();
+			int num_args = OPERAND_B();
+			int c = OPERAND_C();
+			Value callee = R[a];
+			if (callee.isFn()) {
+				FnProto* proto = cachedProto(frame->proto, c, callee, num_args);
+				JitFn* jit_fn = tierUp(proto);
+				if (jit_fn != NULL) {
+					R[a] = callJit(jit_fn, &R[a + 1], num_args);
+					DISPATCH();
+				}
+				frame->pc = pc;
+				pushFrame(proto, frame->base + a + 1);
+				LOAD_FRAME();
+				DISPATCH();
+			} else if (callee.isNative()) {
+				R[a] = callNative(callee.asNative(), &R[a + 1], num_args);
+				DISPATCH();
+			}
+			FATAL("Callee expected to be function type(%d), but (%d)", VALUE_FN, callee.value_type());
+		}
+
+		// The arguments are moved to the bottom of the current frame, which is then replaced by
+		// the frame of the callee. So the callee returns right to the caller of this function.
+		CASE(OP_TAILCALL) {
+			int a = OPERAND_A();
+			int num_args = OPERAND_B();
+			int c = OPERAND_C();
+			Value callee = R[a];
+			if (callee.isFn()) {
+				FnProto* proto = cachedProto(frame->proto, c, callee, num_args);
+				JitFn* jit_fn = tierUp(proto);
+				if (jit_fn != NULL) {
+					Value res = callJit(jit_fn, &R[a + 1], num_args);
+					if (popFrame(res, stop_depth)) {
+						return res;
+					}
+					LOAD_FRAME();
+					DISPATCH();
+				}
+				int base = frame->base;
+				copy(R + a + 1, R + a + 1 + num_args, R);
+				_frames.pop_back();
+				pushFrame(proto, base);
+				LOAD_FRAME();
+				DISPATCH();
+			} else if (callee.isNative()) {
+				Value res = callNative(callee.asNative(), &R[a + 1], num_args);
+				if (popFrame(res, stop_depth)) {
+					return res;
+				}
+				LOAD_FRAME();
+				DISPATCH();
+			}
+			FATAL("Callee expected to be function type(%d), but (%d)", VALUE_FN, callee.value_type());
+		}
+
+		CASE(OP_RET) {
+			Value res = R[OPERAND_A()];
+			if (popFrame(res, stop_depth)) {
+				return res;
+			}
+			LOAD_FRAME();
+			DISPATCH();
+		}
+
+		BINARY_OPK(OP_ADDK, add)
+		BINARY_OPK(OP_SUBK, sub)
+
+		CASE(OP_JCMP) {
+			BRANCH_IF(compare(OPERAND_C(), R[OPERAND_A()], R[OPERAND_B()]));
+			DISPATCH();
+		}
+
+		CASE(OP_JCMPK) {
+			BRANCH_IF(compare(OPERAND_C(), R[OPERAND_A()], K[OPERAND_B()]));
+			DISPATCH();
+		}
+
+		QUICK_INT_OP(OP_ADD_II, +, OP_ADD)
+		QUICK_INT_OP(OP_SUB_II, -, OP_SUB)
+		QUICK_INT_OP(OP_MUL_II, *, OP_MUL)
+
+#ifndef RING_COMPUTED_GOTO
+		default:
+			FATAL("Unknown opcode %d", InstrUtil::op(i));
+		}
+	}
+#endif
+	return Value::Nil();
+}
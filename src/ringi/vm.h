@@ -0,0 +1,100 @@
+#ifndef RING_RINGI_VM_H
+#define RING_RINGI_VM_H
+
+
+namespace ring {
+namespace ringi {
+	class VM;
+}}
+
+
+#include "../common.h"
+#include "../ringc/session/session.h"
+#include "bytecode.h"
+#include "heap.h"
+#include "jit.h"
+#include "values.h"
+#include <vector>
+using namespace ring::ringc;
+using namespace std;
+
+
+namespace ring {
+namespace ringi {
+
+
+// VM runs register bytecode.
+// Ring calls do not recurse on the native stack: every call pushes a frame on the VM frame stack
+// and the registers of all frames live in one contiguous register stack.
+// The registers of live frames and the globals are roots of the heap.
+// With a JIT, functions are counted as they run and the hot ones are called as native code.
+class VM : public GcRoots {
+	ADD_PROPERTY_P(session, Session)
+	ADD_PROPERTY_P(bc_module, BytecodeModule)
+	ADD_PROPERTY_P(heap, Heap)
+	ADD_PROPERTY_P(jit, JIT)
+
+public:
+	VM(Session* session, BytecodeModule* bc_module, Heap* heap);
+	~VM();
+
+	// Runs the module initializer.
+	void initModule();
+
+	// Calls a function value with the given arguments and returns its result.
+	Value call(Value fn, const vector<Value>& args);
+
+	// Returns the value of a global, none if there is no such global.
+	Value global(const string& name);
+
+	void markRoots(Heap* heap);
+
+protected:
+	struct CallFrame {
+		FnProto* proto;
+		Instr* pc;
+		int base;
+	};
+
+	// Runs from the top frame until the frame at `stop_depth` returns.
+	Value run(int stop_depth);
+
+	// Returns the first register above the top frame.
+	int stackTop() const;
+
+	// Returns the checked code of a ring function called with `num_args` arguments.
+	FnProto* calleeProto(Value callee, int num_args);
+	FnProto* cachedProto(FnProto* caller, int c, Value callee, int num_args);
+
+	// Pushes a new frame whose registers begin at `base`.
+	void pushFrame(FnProto* proto, int base);
+
+	// Pops the top frame and passes `res` to the caller.
+	// Returns true when the frame at `stop_depth` returned.
+	bool popFrame(Value res, int stop_depth);
+
+	// Makes room for `size` registers from `base`.
+	void ensureStack(int base, int size);
+
+	// Counts a call of `proto` and compiles it once it gets hot.
+	// Returns its native code, NULL while it is interpreted.
+	JitFn* tierUp(FnProto* proto);
+
+	Value callNative(NativeFn* fn, Value* args, int num_args);
+	Value callJit(JitFn* fn, Value* args, int num_args);
+
+	// Calls native code which takes and returns ints.
+	int callInts(void* addr, const string& name, Value* args, int num_args);
+
+protected:
+	vector<Value> _stack;
+	vector<CallFrame> _frames;
+	vector<Value> _globals;
+};
+
+
+} // namespace ringi
+} // namespace ring
+
+
+#endif